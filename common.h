@@ -3,7 +3,7 @@
  * Author: savop
  * Author: J.Huber, IRT GmbH
  * Created on 19. April 2009, 15:22
- * Modified on January 24, 2013
+ * Modified on October 17, 2026
  */
 
 #ifndef _COMMON_H
@@ -245,14 +245,72 @@ void message(int level, const char* File, int Line, const char* Format, ...) __a
 #define SETUP_PREVIEW_EPG_DAYS  "Epg.Preview"
 #define SETUP_EPG_DATA_FILE     "Epg.Datafile"
 #define SETUP_AMOUNT_CHANNELS   "Channels.Amount"
+#define SETUP_LIVE_SLOW_READER  "Live.SlowReader"
+#define SETUP_LIVE_POOL_TIME    "Live.PoolTime"
+#define SETUP_LIVE_PRETUNE      "Live.Pretune"
+#define SETUP_LIVE_TIMESHIFT    "Live.Timeshift"
+#define SETUP_LIVE_TIMESHIFT_DIR "Live.TimeshiftDirectory"
+#define SETUP_LIVE_BUFFER_MIN   "Live.BufferMin"
+#define SETUP_LIVE_BUFFER_MAX   "Live.BufferMax"
+#define SETUP_LIVE_FAILOVER     "Live.Failover"
+#define SETUP_READ_AHEAD        "Stream.ReadAhead"
+#define SETUP_STREAM_PACING     "Stream.Pacing"
+#define SETUP_STREAM_MAX        "Stream.Max"
+#define SETUP_STREAM_MAX_PER_RESOURCE "Stream.MaxPerResource"
 
 /* The server port range where the server interacts with clients */
 #define SERVER_MIN_PORT         49152
 #define SERVER_MAX_PORT         65535
 
-#define RECEIVER_LIVEBUFFER_SIZE     MB(1)
-#define RECEIVER_OUTPUTBUFFER_SIZE   MB(1)
-#define RECEIVER_RINGBUFFER_MARGIN   10*TS_SIZE
+#define RECEIVER_LIVEBUFFER_SIZE     MB(2)      // the initial size, until the bitrate is known
+#define RECEIVER_LIVEBUFFER_MIN      256        // KB
+#define RECEIVER_LIVEBUFFER_MAX      16384      // KB
+#define RECEIVER_LIVEBUFFER_SECONDS  2          // the buffer holds the data of 2 seconds
+#define RECEIVER_RESIZE_INTERVAL     5000       // measure the bitrate every 5 seconds
+#define RECEIVER_SWAP_TIMEOUT        100        // ms to wait for the writer to take over a resized buffer
+#define RECEIVER_POOL_INTERVAL       1000 // check the idle receivers every second
+#define RECEIVER_FAILOVER_TIMEOUT    2000       // a receiver without data for 2 seconds fails over
+#define RECEIVER_WATCHDOG_INTERVAL   250        // check the receivers for data every 250 ms
+#define RECEIVER_FAILOVER_ATTEMPTS   3          // give up after 3 devices delivered no data
+#define RECEIVER_TIMESHIFT_RING      MB(4)      // the data queued for the timeshift writer
+#define RECEIVER_TIMESHIFT_WAIT      100        // ms the timeshift writer waits for data
+
+#define STREAM_READ_AHEAD            4096       // KB read ahead of recording streams
+#define STREAM_STALL_THRESHOLD       50         // a read of a recording taking 50 ms or more stalled the stream
+#define STREAM_PACING                200        // stream recordings at twice their average rate
+#define STREAM_PACING_BURST          10         // seconds of a stream which may be read at once after the start or a seek
+#define STREAM_MAX                   16         // the number of streams which may be open at once
+#define STREAM_MAX_PER_RESOURCE      4          // the number of streams of the same resource which may be open at once
+#define STREAM_RESERVE               2          // the streams kept free for each higher priority, live TV before recordings before files
+#define DIRECT_IO_ALIGNMENT          4096       // the alignment of buffers, offsets and lengths of direct reads
+#define DIRECT_IO_BUFFER             (KB(1024)) // the size of a direct read
+#define DIRECT_IO_POOL               8          // the number of unused direct read buffers which are kept
+#define TTS_SIZE                     192        // a transport stream packet with a time stamp
+#define TTS_PACKETS                  64         // the number of packets converted at once
+#define TTS_MAX_PCR_INTERVAL         27000000   // PCRs more than a second apart are discontinuities
+#define TTS_CONTENT_TYPE             "video/vnd.dlna.mpeg-tts"
+#define METRICS_CONTENT_TYPE         "text/plain; version=0.0.4"
+#define SEGMENT_TABLE_TTL            1000       // a segment table checked within the last second is up to date
+#define SEGMENT_TABLE_CACHE          32         // the number of segment tables kept without streams
+#define RECORDING_FOLLOW_DELAY       100        // ms to wait first for a recording to grow
+#define RECORDING_FOLLOW_MAX_DELAY   1000       // ms to wait at most between two checks
+#define RECORDING_FOLLOW_TIMEOUT     10000      // end the stream, if the recording did not grow for 10 seconds
+#define RECORDING_INDEX_TIMEOUT      10         // a recording whose index was not written for 10 seconds has finished
+#define TRICK_FRAME_RATE             4          // the number of independent frames per second of a trick play stream
+#define TRICK_MAX_SPEED              64         // the fastest trick play speed
+#define TRICK_MAX_FRAME_SIZE         (KB(2048) / TS_SIZE * TS_SIZE) // the largest independent frame
+#define TRICK_HEADER_PACKETS         64         // the number of packets searched for the PAT and PMT
+#define RECORDING_MAX_CHAPTERS       32         // the number of marks offered as chapters of a recording
+#define WEB_PATH_MAX_LENGTH          512        // the longest query of a stream path
+#define WEB_PATH_MAX_PROPERTIES      16         // the number of properties of a stream path
+#define RESOURCE_CACHE_STRIPES       16         // the number of separately locked parts of the resource cache
+#define RESOURCE_CACHE_EPG_ENTRIES   4096       // the number of resources of EPG items which are kept in the cache
+
+/* What happens to a live stream client which cannot keep up with the broadcast */
+enum RECEIVER_SLOW_READER_POLICIES {
+    RECEIVER_SLOW_READER_DROP,          ///< skip the lost data and continue closer to the live edge
+    RECEIVER_SLOW_READER_DISCONNECT     ///< abort the stream
+};
 
 /****************************************************
  *
@@ -309,6 +367,7 @@ enum UPNP_RESOURCE_TYPES {
 #define UPNP_DIR_XML            "/xml"
 #define UPNP_DIR_SHARES         "/shares"
 #define UPNP_DIR_PRESENTATION   "/http"
+#define UPNP_DIR_METRICS        UPNP_DIR_PRESENTATION "/metrics"
 #define UPNP_DIR_ICONS          "/icons"
 
 /****************************************************
@@ -729,6 +788,8 @@ enum UPnPWriteStatus {
 #define DLNA_TRANSFER_PROTOCOL_HTTP         1           ///< use http tranfer
 #define DLNA_TRANSFER_PROTOCOL_RTP          2           ///< use rtp tranfer
 
+#define DLNA_MAX_PROTOCOL_INFO              256         ///< the longest protocol info or content features
+
 /****************************************************
  *
  * 3.2 Protocol info flags
@@ -758,6 +819,17 @@ enum UPnPWriteStatus {
                                             DLNA_FLAG_CONNECTION_STALLING | \
                                             DLNA_FLAG_VERSION_1_5
 
+#define DLNA_STREAMING_FLAGS                DLNA_FLAG_STREAMING_TRANSFER | \
+                                            DLNA_FLAG_BACKGROUND_TRANSFER | \
+                                            DLNA_FLAG_CONNECTION_STALLING | \
+                                            DLNA_FLAG_VERSION_1_5
+
+/* Live TV with timeshift: the window moves at both ends, so byte seeks are limited to it */
+#define DLNA_TIMESHIFT_FLAGS                DLNA_FLAG_BYTE_BASED_SEEK | \
+                                            DLNA_FLAG_S0_INCREASE | \
+                                            DLNA_FLAG_SN_INCREASE | \
+                                            DLNA_STREAMING_FLAGS
+
 /****************************************************
  *
  * 3.3 Media profiles
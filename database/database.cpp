@@ -3,7 +3,7 @@
  * Author: savop
  * Author: J.Huber, IRT GmbH
  * Created on 3. September 2009, 22:20
- * Last modification: April 9, 2013
+ * Last modification: October 17, 2026
  */
 
 #include <string.h>
@@ -14,6 +14,7 @@
 #include "object.h"
 #include "../upnp.h"
 #include "config.h"
+#include "metrics.h"
 
 cSQLiteDatabase* cSQLiteDatabase::mInstance = NULL;
 
@@ -157,6 +158,10 @@ bool cRow::fetchColumn(char** Column, char** Value){
     return true;
 }
 
+void cSQLiteDatabase::profile(void*, const char* Statement, sqlite3_uint64 Nanoseconds){
+    cMetrics::getInstance()->observeStatement(Statement, Nanoseconds / 1000);
+}
+
 int cSQLiteDatabase::initialize(){
     int ret;
     const char* dbdir = (cUPnPConfig::get()->mDatabaseFolder) ? cUPnPConfig::get()->mDatabaseFolder : cPluginUpnp::getConfigDirectory();
@@ -173,6 +178,8 @@ int cSQLiteDatabase::initialize(){
 	if (sqlite3_exec(this->mDatabase, "PRAGMA journal_mode = MEMORY", NULL, NULL, &Error)){
 		ERROR("Error while setting journal mode to memory: %s", Error);
 	}
+    // Time every statement, the prepared ones of the mediators as well
+    sqlite3_profile(this->mDatabase, cSQLiteDatabase::profile, this);
     MESSAGE(VERBOSE_SDK,"Database file %s opened. SQLITE version: %s", *File, sqlite3_libversion());
     if (this->initializeTables()){
         ERROR("Error while creating tables");
@@ -0,0 +1,91 @@
+/*
+ * File:   marktable.cpp
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#include <sys/stat.h>
+#include <algorithm>
+#include <vdr/tools.h>
+#include "marktable.h"
+
+cMarkTable::cMarkTable(){
+    this->mFramesPerSecond = DEFAULTFRAMESPERSECOND;
+    this->mModified = 0;
+    this->mPass = 0;
+}
+
+cMarkTables* cMarkTables::mInstance = NULL;
+
+cMarkTables::cMarkTables(){
+    this->mPass = 0;
+}
+
+cMarkTables* cMarkTables::getInstance(){
+    if(cMarkTables::mInstance == NULL)
+        cMarkTables::mInstance = new cMarkTables();
+
+    return cMarkTables::mInstance;
+}
+
+void cMarkTables::update(const cRecording* Recording){
+    cString FileName = cString::sprintf("%s/%s", Recording->FileName(), Recording->IsPesRecording() ? "marks.vdr" : "marks");
+    struct stat Stat;
+    cMutexLock MutexLock(&this->mMutex);
+    if(stat(FileName, &Stat) < 0){
+        this->mTables.erase(Recording->FileName());
+        return;
+    }
+    std::map<std::string, cMarkTable>::iterator It = this->mTables.find(Recording->FileName());
+    if(It != this->mTables.end() && It->second.mModified == Stat.st_mtime){
+        It->second.mPass = this->mPass;
+        return;
+    }
+    cMarks Marks;
+    if(!Marks.Load(Recording->FileName(), Recording->FramesPerSecond(), Recording->IsPesRecording()) || !Marks.Count()){
+        this->mTables.erase(Recording->FileName());
+        return;
+    }
+    cMarkTable Table;
+    Table.mFramesPerSecond = Recording->FramesPerSecond();
+    Table.mModified = Stat.st_mtime;
+    Table.mPass = this->mPass;
+    for(cMark* Mark = Marks.First(); Mark; Mark = Marks.Next(Mark)){
+        Table.mFrames.push_back(Mark->Position());
+    }
+    std::sort(Table.mFrames.begin(), Table.mFrames.end());
+    MESSAGE(VERBOSE_RECORDS, "Recording %s has %d marks", Recording->Name(), Table.count());
+    this->mTables[Recording->FileName()] = Table;
+}
+
+bool cMarkTables::get(const char* FileName, cMarkTable* Table){
+    cMutexLock MutexLock(&this->mMutex);
+    std::map<std::string, cMarkTable>::iterator It = this->mTables.find(FileName);
+    if(It == this->mTables.end()){
+        return false;
+    }
+    *Table = It->second;
+    return true;
+}
+
+int cMarkTables::prune(){
+    cMutexLock MutexLock(&this->mMutex);
+    int Pruned = 0;
+    std::map<std::string, cMarkTable>::iterator It = this->mTables.begin();
+    while(It != this->mTables.end()){
+        // The recording was not seen in the last pass
+        if(It->second.mPass != this->mPass){
+            this->mTables.erase(It++);
+            Pruned++;
+        }
+        else {
+            ++It;
+        }
+    }
+    this->mPass++;
+    if(Pruned){
+        MESSAGE(VERBOSE_RECORDS, "Removed the marks of %d deleted recordings", Pruned);
+    }
+    return Pruned;
+}
@@ -3,7 +3,7 @@
  * Author: savop
  * Author: J.Huber, IRT GmbH
  * Created on 28. Mai 2009, 16:50
- * Last modification: April 9, 2013
+ * Last modification: October 17, 2026
  */
 
 #include <upnp/ixml.h>
@@ -23,6 +23,7 @@
 #include <sys/stat.h>
 #include "vdrepg.h"
 #include "config.h"
+#include "marktable.h"
 
  /**********************************************\
  *                                              *
@@ -71,6 +72,7 @@ bool cMediaDatabase::init(){
         ERROR("Loading channels failed");
         return false;
     }
+    cUPnPResources::getInstance()->preloadResources(UPNP_RESOURCE_CHANNEL);
 #endif
 	this->mIsInitialised = true;
 #ifndef WITHOUT_RECORDS
@@ -1241,6 +1243,7 @@ void cMediaDatabase::updateRecordings(){
             bool inList = false;
 			bool isRadio = false;
             const cRecordingInfo* RecInfo = Recording->Info();
+            cMarkTables::getInstance()->update(Recording);
             MESSAGE(VERBOSE_RECORDS, "Determine whether the stored record %s is already listed in the database", Recording->FileName());
 			cEvent* recEvent = (cEvent*)RecInfo->GetEvent();
 			if (recEvent){
@@ -1316,6 +1319,7 @@ void cMediaDatabase::updateRecordings(){
                 MESSAGE(VERBOSE_RECORDS, "Skipping %s while updating the recordings' file sizes", Recording->FileName());
             }
         }
+        cMarkTables::getInstance()->prune();
     }
 }
 
@@ -1335,6 +1339,8 @@ int cMediaDatabase::loadRecordings(){
             bool inList = false;
 			bool isRadio = false;
             const cRecordingInfo* RecInfo = Recording->Info();
+            // The marks may change while the recording is listed already
+            cMarkTables::getInstance()->update(Recording);
             MESSAGE(VERBOSE_RECORDS, "Determine if the stored record '%s' is already listed in the database", Recording->FileName());
 			cEvent* recEvent = (cEvent*)RecInfo->GetEvent();
 			if (recEvent){
@@ -1423,6 +1429,7 @@ int cMediaDatabase::loadRecordings(){
                 MESSAGE(VERBOSE_RECORDS, "Skipping '%s', the record is already in the database", Recording->FileName());
             }
         }
+        cMarkTables::getInstance()->prune();
     }
     return 0;
 }
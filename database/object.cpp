@@ -16,6 +16,7 @@
 #include "object.h"
 #include "resources.h"
 #include "config.h"
+#include "marktable.h"
 
 static int CompareUPnPObjects(const void *a, const void *b){
   const cUPnPClassObject *la = *(const cUPnPClassObject **)a;
@@ -785,6 +786,27 @@ IXML_Node* cUPnPClassItem::createDIDLResFragment(cStringList* Filter, IXML_Eleme
 			}
 			ixmlAddFilteredProperty(Filter, this->mDIDLFragment, eRes, UPNP_PROP_SIZE, cString::sprintf("%lld", fileSize));
 		}
+		if(eRes && config->mTimestampedTS && Resource->getContentType() && !strncmp(Resource->getContentType(), "video/", 6) &&
+		   (Resource->getResourceType() == UPNP_RESOURCE_RECORDING || Resource->getResourceType() == UPNP_RESOURCE_CHANNEL)){
+			// The same stream with time stamps, see cTimestampedStream
+			IXML_Element* eTts = ixmlAddFilteredProperty(Filter, this->mDIDLFragment, eItem, UPNP_PROP_RESOURCE,
+			                                             cString::sprintf("%s&tts=1", *ResourceURL));
+			if(eTts){
+				ixmlAddFilteredProperty(Filter, this->mDIDLFragment, eTts, UPNP_PROP_PROTOCOLINFO, "http-get:*:" TTS_CONTENT_TYPE ":*");
+			}
+		}
+		cMarkTable Marks;
+		if(eRes && Resource->getResourceType() == UPNP_RESOURCE_RECORDING &&
+		   cMarkTables::getInstance()->get(Resource->getResource(), &Marks)){
+			// Every mark is a chapter, which starts the recording at the mark
+			for(int Mark = 1; Mark <= Marks.count() && Mark <= RECORDING_MAX_CHAPTERS; Mark++){
+				IXML_Element* eChapter = ixmlAddFilteredProperty(Filter, this->mDIDLFragment, eItem, UPNP_PROP_RESOURCE,
+				                                                 cString::sprintf("%s&mark=%d", *ResourceURL, Mark));
+				if(eChapter){
+					ixmlAddFilteredProperty(Filter, this->mDIDLFragment, eChapter, UPNP_PROP_PROTOCOLINFO, Resource->getProtocolInfo());
+				}
+			}
+		}
 	}
     return (IXML_Node*)eItem;
 }
@@ -3,7 +3,7 @@
  * Author: savop
  * Author: J.Huber, IRT GmbH
  * Created on 30. September 2009, 15:17
- * Last modification: April 9, 2013
+ * Last modification: October 17, 2026
  */
 
 #include <string.h>
@@ -13,6 +13,7 @@
 #include "resources.h"
 #include "avdetector.h"
 #include "vdrepg.h"
+#include "config.h"
 
 cUPnPResource::cUPnPResource(){
     this->mBitrate = 0;
@@ -25,12 +26,46 @@ cUPnPResource::cUPnPResource(){
     this->mResolution = NULL;
     this->mResource = NULL;
     this->mResourceID = 0;
+    this->mResourceType = -1;
     this->mSampleFrequency = 0;
     this->mSize = 0;
 	this->mRecordTimer = 0;
     this->mContentType = NULL;
+    this->mContentFeatures = NULL;
 	this->mObjectId = -1;
 	this->mCacheAdded = false;
+    this->mCacheOwned = false;
+    this->mReferences = 0;
+    this->mDlnaOperation = DLNA_OPERATION_NONE;
+    this->mDlnaFlags = DLNA_STREAMING_FLAGS;
+}
+
+void cUPnPResource::initContentFeatures(){
+    switch(this->mResourceType){
+        case UPNP_RESOURCE_RECORDING:
+        case UPNP_RESOURCE_FILE:
+            // The players seek to any byte of the file
+            this->mDlnaOperation = DLNA_OPERATION_RANGE;
+            this->mDlnaFlags = DLNA_STREAMING_FLAGS;
+            break;
+        case UPNP_RESOURCE_CHANNEL:
+            this->mDlnaOperation = DLNA_OPERATION_NONE;
+            this->mDlnaFlags = (cUPnPConfig::get()->mLiveTimeshift > 0) ? DLNA_TIMESHIFT_FLAGS : DLNA_STREAMING_FLAGS;
+            break;
+        default:
+            this->mDlnaOperation = DLNA_OPERATION_NONE;
+            this->mDlnaFlags = DLNA_STREAMING_FLAGS;
+    }
+    // The profile is taken from the fourth field of the protocol info
+    char Profile[64];
+    const char* PN = (*this->mProtocolInfo) ? strstr(this->mProtocolInfo, "DLNA.ORG_PN=") : NULL;
+    if(PN){
+        PN += strlen("DLNA.ORG_PN=");
+        snprintf(Profile, sizeof(Profile), "%.*s", (int)strcspn(PN, ";"), PN);
+    }
+    char Features[DLNA_MAX_PROTOCOL_INFO];
+    this->mContentFeatures = cDlna::getContentFeatures(Features, sizeof(Features), PN ? Profile : NULL,
+                                                       this->mDlnaOperation, NULL, DLNA_CONVERSION_NONE, this->mDlnaFlags);
 }
 
 time_t cUPnPResource::getLastModification() const {
@@ -81,10 +116,147 @@ void cUPnPResource::setBitrate(unsigned int bitRate){
 	this->mBitrate = bitRate;
 }
 
+cResourceCache::cResourceCache(){
+    this->mHits = 0;
+    this->mMisses = 0;
+    this->mEvictions = 0;
+}
+
+cResourceCache::~cResourceCache(){
+    for(int i = 0; i < RESOURCE_CACHE_STRIPES; i++){
+        cStripe* Stripe = &this->mStripes[i];
+        for(std::map<unsigned int, cUPnPResource*>::iterator It = Stripe->mEntries.begin(); It != Stripe->mEntries.end(); It++){
+            It->second->mCacheAdded = false;
+            this->release(It->second);
+        }
+    }
+}
+
+cResourceCache::cStripe* cResourceCache::stripeOf(unsigned int ResourceID){
+    return &this->mStripes[ResourceID % RESOURCE_CACHE_STRIPES];
+}
+
+cUPnPResource* cResourceCache::get(unsigned int ResourceID){
+    cStripe* Stripe = this->stripeOf(ResourceID);
+    cUPnPResource* Resource = NULL;
+    Stripe->mLock.Lock(false);
+    std::map<unsigned int, cUPnPResource*>::iterator It = Stripe->mEntries.find(ResourceID);
+    if(It != Stripe->mEntries.end()){
+        Resource = It->second;
+        // The reference of the cache keeps the resource until this one is taken
+        __sync_add_and_fetch(&Resource->mReferences, 1);
+    }
+    Stripe->mLock.Unlock();
+    // Several lookups share the lock, so the counters are incremented atomically
+    __sync_fetch_and_add(Resource ? &this->mHits : &this->mMisses, 1);
+    return Resource;
+}
+
+void cResourceCache::release(cUPnPResource* Resource){
+    // An object, which took the resource over, took it while holding a reference
+    if(__sync_sub_and_fetch(&Resource->mReferences, 1) == 0 && Resource->mCacheOwned){
+        MESSAGE(VERBOSE_METADATA, "Deleting the resource with ID %d", Resource->getID());
+        delete Resource;
+    }
+}
+
+void cResourceCache::add(cUPnPResource* Resource){
+    cStripe* Stripe = this->stripeOf(Resource->getID());
+    cUPnPResource* Replaced = NULL;
+    Stripe->mLock.Lock(true);
+    cUPnPResource*& Entry = Stripe->mEntries[Resource->getID()];
+    if(Entry != Resource){
+        if(Entry){
+            // The resource replaces another one with the same ID
+            Replaced = Entry;
+            Replaced->mCacheAdded = false;
+        }
+        else if(Resource->getID() >= SQLITE_FIRST_EPG_RESOURCE_ID_NR){
+            Stripe->mEpgEntries.push_back(Resource->getID());
+            Stripe->mEpgCount++;
+        }
+        __sync_add_and_fetch(&Resource->mReferences, 1);
+        Entry = Resource;
+        Resource->mCacheAdded = true;
+    }
+    std::vector<cUPnPResource*> Evicted;
+    this->evict(Stripe, Evicted);
+    Stripe->mLock.Unlock();
+    if(Replaced){
+        this->release(Replaced);
+    }
+    for(size_t i = 0; i < Evicted.size(); i++){
+        this->release(Evicted[i]);
+    }
+}
+
+void cResourceCache::remove(cUPnPResource* Resource){
+    cStripe* Stripe = this->stripeOf(Resource->getID());
+    bool Removed = false;
+    Stripe->mLock.Lock(true);
+    std::map<unsigned int, cUPnPResource*>::iterator It = Stripe->mEntries.find(Resource->getID());
+    if(It != Stripe->mEntries.end() && It->second == Resource){
+        Stripe->mEntries.erase(It);
+        if(Resource->getID() >= SQLITE_FIRST_EPG_RESOURCE_ID_NR){
+            Stripe->mEpgCount--;
+        }
+        Removed = true;
+    }
+    Resource->mCacheAdded = false;
+    Stripe->mLock.Unlock();
+    if(Removed){
+        this->release(Resource);
+    }
+}
+
+void cResourceCache::adopt(cUPnPResource* Resource){
+    cStripe* Stripe = this->stripeOf(Resource->getID());
+    Stripe->mLock.Lock(true);
+    Resource->mCacheOwned = false;
+    Stripe->mLock.Unlock();
+}
+
+int cResourceCache::getCount(){
+    int Count = 0;
+    for(int i = 0; i < RESOURCE_CACHE_STRIPES; i++){
+        this->mStripes[i].mLock.Lock(false);
+        Count += (int)this->mStripes[i].mEntries.size();
+        this->mStripes[i].mLock.Unlock();
+    }
+    return Count;
+}
+
+void cResourceCache::evict(cStripe* Stripe, std::vector<cUPnPResource*>& Evicted){
+    const int Capacity = RESOURCE_CACHE_EPG_ENTRIES / RESOURCE_CACHE_STRIPES;
+    while(Stripe->mEpgCount > Capacity && !Stripe->mEpgEntries.empty()){
+        unsigned int ResourceID = Stripe->mEpgEntries.front();
+        Stripe->mEpgEntries.pop_front();
+        std::map<unsigned int, cUPnPResource*>::iterator It = Stripe->mEntries.find(ResourceID);
+        // The IDs of removed resources are skipped
+        if(It != Stripe->mEntries.end()){
+            It->second->mCacheAdded = false;
+            Evicted.push_back(It->second);
+            Stripe->mEntries.erase(It);
+            Stripe->mEpgCount--;
+            __sync_fetch_and_add(&this->mEvictions, 1);
+        }
+    }
+    // Drop the IDs of removed resources, if the EPG is updated without evictions
+    if(Stripe->mEpgEntries.size() > (size_t)(2 * Capacity)){
+        std::deque<unsigned int> EpgEntries;
+        for(size_t i = 0; i < Stripe->mEpgEntries.size(); i++){
+            if(Stripe->mEntries.count(Stripe->mEpgEntries[i])){
+                EpgEntries.push_back(Stripe->mEpgEntries[i]);
+            }
+        }
+        Stripe->mEpgEntries.swap(EpgEntries);
+    }
+}
+
 cUPnPResources* cUPnPResources::mInstance = NULL;
 
 cUPnPResources::cUPnPResources(){
-    this->mResources = new cHash<cUPnPResource>;
+    this->mResources = new cResourceCache;
     this->mMediator = new cUPnPResourceMediator;
     this->mDatabase = cSQLiteDatabase::getInstance();
 }
@@ -115,13 +287,41 @@ int cUPnPResources::loadResources(){
         while(Row->fetchColumn(&Column, &Value)){
             if(!strcasecmp(Column, SQLITE_COL_RESOURCEID)){
                 unsigned int ResourceID = (unsigned int)atoi(Value);
-                this->getResource(ResourceID);
+                cUPnPResource* Resource = this->getResource(ResourceID);
+                if(Resource){
+                    this->releaseResource(Resource);
+                }
             }
         }
     }
     return 0;
 }
 
+int cUPnPResources::preloadResources(int ResourceType){
+    if(this->mDatabase->execStatement("SELECT %s FROM %s WHERE %s=%d",
+                                        SQLITE_COL_RESOURCEID,
+                                        SQLITE_TABLE_RESOURCES,
+                                        SQLITE_COL_RESOURCETYPE,
+                                        ResourceType)){
+        ERROR("Error while executing statement, 'preloadResources'");
+        return -1;
+    }
+    int Count = 0;
+    cRows* Rows = this->mDatabase->getResultRows(); cRow* Row;
+    cString Column = NULL, Value = NULL;
+    while(Rows->fetchRow(&Row)){
+        while(Row->fetchColumn(&Column, &Value)){
+            cUPnPResource* Resource;
+            if(!strcasecmp(Column, SQLITE_COL_RESOURCEID) && (Resource = this->getResource((unsigned int)atoi(Value)))){
+                this->releaseResource(Resource);
+                Count++;
+            }
+        }
+    }
+    MESSAGE(VERBOSE_METADATA, "Preloaded %d resources of type %d", Count, ResourceType);
+    return Count;
+}
+
 int cUPnPResources::getResourcesOfObject(cUPnPClassObject* Object){
 	if (Object == NULL){
 	    ERROR("cUPnPResources::getResourcesOfObject: No valid Object was given");
@@ -155,7 +355,7 @@ int cUPnPResources::getResourcesOfObject(cUPnPClassObject* Object){
 	sqlite3_reset(resSelObjStmt);
 	pthread_mutex_unlock(&(this->mDatabase->mutex_resource));
     if (resourceId >= 0){
-		Object->addResource(this->getResource((unsigned int) resourceId));
+		Object->addResource(this->adoptResource((unsigned int) resourceId));
 	}
 
 	if (!actionSuccess){
@@ -176,7 +376,7 @@ int cUPnPResources::getResourcesOfObject(cUPnPClassObject* Object){
 					 MESSAGE(VERBOSE_METADATA, "For the upnp object with ID %d the resource with ID %s was found in the database",
 							 (unsigned int) Object->getID(), *Value);
 					unsigned int ResourceID = (unsigned int)atoi(Value);
-					Object->addResource(this->getResource(ResourceID));
+					Object->addResource(this->adoptResource(ResourceID));
 				}
 			}
 		}
@@ -186,11 +386,15 @@ int cUPnPResources::getResourcesOfObject(cUPnPClassObject* Object){
 
 cUPnPResource* cUPnPResources::getResource(unsigned int ResourceID){
     cUPnPResource* Resource;
-    if((Resource = this->mResources->Get(ResourceID))){
+    if((Resource = this->mResources->get(ResourceID))){
 //        MESSAGE(VERBOSE_METADATA, "Found cached resource");
         return Resource;
     }
     else if((Resource = this->mMediator->getResource(ResourceID))){
+        // The cache deletes the resource, unless an object takes it over
+        Resource->mCacheOwned = true;
+        // The reference of the caller is taken before anybody else can evict it
+        Resource->mReferences = 1;
 		addCache(Resource);
         return Resource;
     }
@@ -200,6 +404,19 @@ cUPnPResource* cUPnPResources::getResource(unsigned int ResourceID){
     }
 }
 
+void cUPnPResources::releaseResource(cUPnPResource* Resource){
+    this->mResources->release(Resource);
+}
+
+cUPnPResource* cUPnPResources::adoptResource(unsigned int ResourceID){
+    cUPnPResource* Resource = this->getResource(ResourceID);
+    if(Resource){
+        this->mResources->adopt(Resource);
+        this->mResources->release(Resource);
+    }
+    return Resource;
+}
+
 int cUPnPResources::createFromRecording(cUPnPClassObject* Object, cRecording* Recording){
     if(!Object || !Recording){
         ERROR("createFromRecording: Invalid input arguments");
@@ -220,7 +437,7 @@ int cUPnPResources::createFromRecording(cUPnPClassObject* Object, cRecording* Re
         return -1;
     }
 
-    const char* ProtocolInfo = cDlna::getInstance()->getProtocolInfo(Detector->getDLNAProfile());
+    const char* ProtocolInfo = cDlna::getInstance()->getProtocolInfo(Detector->getDLNAProfile(), DLNA_OPERATION_RANGE);
     MESSAGE(VERBOSE_METADATA, "Protocol info: %s", ProtocolInfo);   
     cString ResourceFile     = Recording->FileName();
     cUPnPResource* Resource  = this->mMediator->newResource(Object, UPNP_RESOURCE_RECORDING, ResourceFile, Detector->getDLNAProfile()->mime, ProtocolInfo, false);
@@ -314,7 +531,9 @@ int cUPnPResources::createFromChannel(cUPnPClassObject* Object, cChannel* Channe
         return -1;
     }
 
-    const char* ProtocolInfo = cDlna::getInstance()->getProtocolInfo(Detector->getDLNAProfile());
+    const char* ProtocolInfo = (cUPnPConfig::get()->mLiveTimeshift > 0) ?
+        cDlna::getInstance()->getProtocolInfo(Detector->getDLNAProfile(), DLNA_OPERATION_NONE, NULL, -1, DLNA_TIMESHIFT_FLAGS) :
+        cDlna::getInstance()->getProtocolInfo(Detector->getDLNAProfile());
     MESSAGE(VERBOSE_METADATA, "Protocol info: %s", ProtocolInfo);
 
     // Index which may be used to indicate different resources with same channel ID
@@ -367,8 +586,7 @@ int cUPnPResources::deleteCachedResources(cUPnPClassObject* delObject){
 	for (Resource = resList->First(); Resource && ctr++ < resCount; ){
 		if (Resource && Resource->getID() && this->mResources && Resource->mCacheAdded){
 		    MESSAGE(VERBOSE_METADATA, "deleteCachedResources: Remove the cached resource with ID: %d", Resource->getID());
-			this->mResources->Del(Resource, Resource->getID());
-			Resource->mCacheAdded = false;
+			this->mResources->remove(Resource);
 		}
 		if (ctr < resCount){
 			Resource = resList->Next(Resource);
@@ -382,8 +600,7 @@ void cUPnPResources::addCache(cUPnPResource* resource){
 		ERROR("cUPnPResources::addCache: the resource is NULL");
 		return;
 	}
-	this->mResources->Add(resource, resource->getID());
-	resource->mCacheAdded = true;
+	this->mResources->add(resource);
 }
 
 cUPnPResourceMediator::cUPnPResourceMediator(){
@@ -463,6 +680,7 @@ cUPnPResource* cUPnPResourceMediator::getResource(unsigned int ResourceID){
 	sqlite3_clear_bindings(this->mResSelStmt);
 	sqlite3_reset(this->mResSelStmt);
 	pthread_mutex_unlock(&(this->mDatabase->mutex_resource));
+    Resource->initContentFeatures();
     return Resource;
 }
 
@@ -595,6 +813,7 @@ cUPnPResource* cUPnPResourceMediator::newResource(cUPnPClassObject* Object, int
     Resource->mProtocolInfo = ProtocolInfo;
     Resource->mContentType = ContentType;
     Resource->mResourceType = ResourceType;
+    Resource->initContentFeatures();
     if(actionSuccess){
 		this->mDatabase->commitTransaction();        
     }
@@ -9,6 +9,7 @@
 #include "avdetector.h"
 #include "profiles/container.h"
 #include "object.h"
+#include "config.h"
 #include <sys/stat.h>
 
 cAudioVideoDetector::cAudioVideoDetector(const char* Filename) : mResourceType(UPNP_RESOURCE_FILE) {
@@ -100,7 +101,13 @@ int cAudioVideoDetector::detectChannelProperties(){
             break;
         default:
 			if (this->mResource.Channel->Frequency() > 0 && this->mResource.Channel->Number() >= 0){
-				this->mDLNAProfile = &DLNA_PROFILE_MP3;
+				// Radio is streamed as plain audio frames, see cLiveStream
+				if (this->mResource.Channel->Atype(0) == 0x0F && !cUPnPConfig::get()->mRadioTS){
+					this->mDLNAProfile = &DLNA_PROFILE_AAC_ADTS;
+				}
+				else {
+					this->mDLNAProfile = &DLNA_PROFILE_MP3;
+				}
 				return 0;
 			}
             ERROR("Unknown video type %d for channel %s!", this->mResource.Channel->Vtype(), this->mResource.Channel->Name());
@@ -1,8 +1,9 @@
 /* 
  * File:   dlna.cpp
  * Author: savop
- * 
+ * Author: J.Huber, IRT GmbH
  * Created on 18. April 2009, 23:27
+ * Last modification: October 17, 2026
  */
 
 #include <stdio.h>
@@ -55,22 +56,33 @@ const char* cDlna::getSupportedProtocols(){
 }
 
 const char* cDlna::getProtocolInfo(DLNAProfile *Profile, int Op, const char* Ps, int Ci, unsigned int Flags){
-    cString DLNA4thField = NULL;
-    DLNA4thField = cString::sprintf("DLNA.ORG_PN=%s", Profile->ID);
+    char DLNA4thField[DLNA_MAX_PROTOCOL_INFO];
+    char Protocol[DLNA_MAX_PROTOCOL_INFO];
+	if (strcmp(Profile->ID, "MP3") == 0){
+		strcpy(DLNA4thField, "*");
+	}
+    else {
+        cDlna::getContentFeatures(DLNA4thField, sizeof(DLNA4thField), Profile->ID, Op, Ps, Ci, Flags);
+    }
+    snprintf(Protocol, sizeof(Protocol), "http-get:*:%s:%s", Profile->mime, DLNA4thField);
+    return strdup(Protocol);
+}
+
+const char* cDlna::getContentFeatures(char* Buffer, size_t Size, const char* ProfileID, int Op, const char* Ps, int Ci, unsigned int Flags){
+    char Operation[16] = "", Conversion[16] = "", FlagsField[48] = "";
     if(Op != -1)
-        DLNA4thField = cString::sprintf("%s;DLNA.ORG_OP=%d",*DLNA4thField,Op);
-    if(Ps != NULL)
-        DLNA4thField = cString::sprintf("%s;DLNA.ORG_PS=%s",*DLNA4thField,Ps);
+        snprintf(Operation, sizeof(Operation), "DLNA.ORG_OP=%.2d;", Op);
     if(Ci != -1)
-        DLNA4thField = cString::sprintf("%s;DLNA.ORG_CI=%d",*DLNA4thField,Ci);
+        snprintf(Conversion, sizeof(Conversion), "DLNA.ORG_CI=%d;", Ci);
     if(Flags != 0)
-        DLNA4thField = cString::sprintf("%s;DLNA.ORG_FLAGS=%.8x%.24x",*DLNA4thField,Flags,0);
-	if (strcmp(Profile->ID, "MP3") == 0){
-		DLNA4thField = cString::sprintf("%s", "*");
-	}
-    char* Protocol = strdup(cString::sprintf("http-get:*:%s:%s", Profile->mime, *DLNA4thField));
-//    char* Protocol = strdup(cString::sprintf("http-get:*:%s:%s", Profile->mime, "*"));
-    return Protocol;
+        snprintf(FlagsField, sizeof(FlagsField), "DLNA.ORG_FLAGS=%.8x%.24x;", Flags, 0);
+    snprintf(Buffer, Size, "%s%s%s%s%s%s%s%s%s", ProfileID ? "DLNA.ORG_PN=" : "", ProfileID ? ProfileID : "", ProfileID ? ";" : "",
+             Operation, Ps ? "DLNA.ORG_PS=" : "", Ps ? Ps : "", Ps ? ";" : "", Conversion, FlagsField);
+    // The fields are separated, not terminated by semicolons
+    size_t Length = strlen(Buffer);
+    if(Length > 0 && Buffer[Length - 1] == ';')
+        Buffer[Length - 1] = 0;
+    return Buffer;
 }
 
 const char* cDlna::getDeviceDescription(const char* URLBase){
@@ -6,3 +6,5 @@
  */
 
 #include "profiles/aac.h"
+
+DLNAProfile DLNA_PROFILE_AAC_ADTS = { "AAC_ADTS", "audio/vnd.dlna.adts" };
@@ -0,0 +1,111 @@
+/*
+ * File:   admission.h
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef _ADMISSION_H
+#define	_ADMISSION_H
+
+#include "../common.h"
+#include <map>
+#include <vdr/thread.h>
+
+/**
+ * The admission control
+ *
+ * This limits the file handles which the webserver opens for streams. It
+ * keeps a table of the open handles per resource and per resource type.
+ *
+ * A stream is rejected, if
+ * - \c mMaxStreams streams are open, less the slots which are reserved for
+ *   streams of a higher priority: live TV comes before recordings, and
+ *   recordings come before files. \c STREAM_RESERVE slots are kept free for
+ *   each higher priority.
+ * - \c mMaxStreamsPerResource streams of the same recording or file are open,
+ *   e.g. a renderer which requests many ranges of a recording in parallel.
+ *   The streams of a channel are not limited this way, because all its
+ *   clients read the buffer of the same receiver. They only count against
+ *   \c mMaxStreams, of which no slots are reserved from live TV.
+ *
+ * The webserver does not know the address of a client, so the streams of a
+ * resource stand for the streams of a client.
+ */
+class cAdmissionControl {
+public:
+    /**
+     * Get the instance
+     *
+     * @return returns the admission control
+     */
+    static cAdmissionControl* getInstance();
+    /**
+     * Checks a stream
+     *
+     * This checks, if a stream of the resource would be admitted, without
+     * opening it. It is used to reject requests before anything is tuned.
+     * Unlike \c admit(), it does not count a rejection.
+     *
+     * @return returns
+     * - \bc true, if the stream would be admitted
+     * - \bc false, otherwise
+     */
+    bool check(
+        unsigned int ResourceID,    ///< the ID of the resource
+        int ResourceType            ///< the type of the resource, one of UPNP_RESOURCE_TYPES
+    );
+    /**
+     * Admits a stream
+     *
+     * If the stream is admitted, it takes a slot, which must be given back
+     * with \c release().
+     *
+     * @return returns
+     * - \bc true, if the stream was admitted
+     * - \bc false, if a limit was reached
+     */
+    bool admit(
+        unsigned int ResourceID,    ///< the ID of the resource
+        int ResourceType            ///< the type of the resource, one of UPNP_RESOURCE_TYPES
+    );
+    /**
+     * Releases a stream
+     */
+    void release(
+        unsigned int ResourceID,    ///< the ID of the resource
+        int ResourceType            ///< the type of the resource, one of UPNP_RESOURCE_TYPES
+    );
+    /**
+     * Gets the number of streams
+     *
+     * @return returns the number of open streams
+     */
+    int getStreams();
+    /**
+     * Gets the number of streams of a type
+     *
+     * @return returns the number of open streams of the resource type
+     */
+    int getStreams(
+        int ResourceType            ///< the type of the resource, one of UPNP_RESOURCE_TYPES
+    );
+    /**
+     * Gets the number of rejected streams
+     *
+     * @return returns the number of streams which were rejected by \c admit()
+     * since the start
+     */
+    long getRejects() const { return this->mRejects; }
+private:
+    static cAdmissionControl* mInstance;
+    cAdmissionControl();
+    bool isAdmissible(unsigned int ResourceID, int ResourceType);
+    std::map<unsigned int, int> mResources;
+    int      mTypes[UPNP_RESOURCE_URL + 1];
+    int      mStreams;
+    long     mRejects;
+    cMutex   mMutex;
+};
+
+#endif	/* _ADMISSION_H */
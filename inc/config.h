@@ -4,7 +4,7 @@
  * Author: J.Huber, IRT GmbH
  *
  * Created on 15. August 2009, 13:03
- * Last modification: April 15, 2013
+ * Last modification: October 17, 2026
  */
 
 #ifndef _CONFIG_H
@@ -62,6 +62,21 @@ public:
 	bool  mOpressTimers;								///< if set the record timer folders are oppressed with contentdirectory::browse()
     bool  mWithoutCA;                                   ///< if set only the free to air channels are selected from channels.conf
 	bool  mChangeRadioClass;  ///< if set change the UPnP class returned in contentdirectory::browse() from object.item.audioitem.audioBroadcast to object.item.videoItem.videoBroadcast
+    int   mLiveSlowReader;                              ///< what happens to live stream clients which fall behind, one of RECEIVER_SLOW_READER_POLICIES
+    int   mLivePoolTime;                                ///< the seconds an idle live receiver stays attached, 0 disables the pool
+    int   mLivePretune;                                 ///< the number of adjacent channels on each side which are pretuned on spare devices
+    int   mLiveTimeshift;                               ///< the size of the timeshift file per channel in MB, 0 disables timeshift
+    char* mLiveTimeshiftDir;                            ///< the directory of the timeshift files
+    int   mLiveBufferMin;                               ///< the minimum size of a live buffer in KB
+    int   mLiveBufferMax;                               ///< the maximum size of a live buffer in KB
+    int   mLiveFailover;                                ///< the milliseconds without data after which a live receiver fails over to another device, 0 disables the watchdog
+    bool  mRadioTS;                                     ///< if set radio channels are streamed as transport stream instead of audio
+    int   mReadAhead;                                   ///< the KB which are read ahead of recording streams, 0 disables the read-ahead
+    int   mPacing;                                      ///< the rate of recording streams in percent of their average rate, 0 disables the pacing
+    bool  mDirectIO;                                    ///< if set recordings are read with O_DIRECT, bypassing the page cache
+    bool  mTimestampedTS;                               ///< if set video resources are offered as timestamped transport stream as well
+    int   mMaxStreams;                                  ///< the number of streams which may be open at once
+    int   mMaxStreamsPerResource;                       ///< the number of streams of the same resource which may be open at once
 public:
     virtual ~cUPnPConfig();
     /**
@@ -3,7 +3,7 @@
  * Author: savop
  * Author: J.Huber, IRT GmbH
  * Created on  September 3, 2009, 22:20
- * Last modification: April 9, 2013
+ * Last modification: October 17, 2026
  */
 
 #ifndef _DATABASE_H
@@ -1082,6 +1082,7 @@ private:
 	 */
     int initializeTriggers();
     static int getResultRow(void* DB, int NumCols, char** Values, char** ColNames);
+    static void profile(void* DB, const char* Statement, sqlite3_uint64 Nanoseconds);
     int exec(const char* Statement);
 
 public:
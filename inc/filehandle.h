@@ -1,13 +1,15 @@
 /* 
  * File:   filehandle.h
  * Author: savop
- *
+ * Author: J.Huber, IRT GmbH
  * Created on 15. Oktober 2009, 10:49
+ * Last modification: October 17, 2026
  */
 
 #ifndef _FILEHANDLE_H
 #define	_FILEHANDLE_H
 
+#include <stdint.h>
 #include <upnp/upnp.h>
 #include "../common.h"
 
@@ -100,6 +102,21 @@ public:
      * This will close open file handles and frees the memory obtained by it.
      */
     virtual void close() = 0;
+    /**
+     * Gets the stalls
+     *
+     * Handles which read recordings count the reads which took at least
+     * \c STREAM_STALL_THRESHOLD milliseconds, see \c cSegmentedFile.
+     *
+     * @return returns the number of stalled reads
+     */
+    virtual long getStalls() const { return 0; }
+    /**
+     * Gets the stall time
+     *
+     * @return returns the total time in milliseconds of the reads which stalled
+     */
+    virtual uint64_t getStallTime() const { return 0; }
     virtual ~cFileHandle(){};
 private:
 };
@@ -3,6 +3,7 @@
  * Author: J.Huber, IRT GmbH
  *
  * Created on Jule 3, 2012
+ * Last modification: October 17, 2026
  */
 
 #ifndef _FILEPLAYER_H
@@ -10,12 +11,14 @@
 
 #include "../common.h"
 #include "filehandle.h"
+#include "segmentedfile.h"
 #include <vdr/recording.h>
 
 /**
  * The file player
  *
  * This class provides the ability to play VDR records consisting of one transport stream.
+ * The files of the record are read with \c cSegmentedFile.
  *
  */
 class cFilePlayer : public cFileHandle {
@@ -36,13 +39,11 @@ public:
     virtual int write(char* buf, size_t buflen);
     virtual int seek(off_t offset, int origin);
     virtual void close();
+    virtual long getStalls() const { return this->mFile->getStalls(); }
+    virtual uint64_t getStallTime() const { return this->mFile->getStallTime(); }
 private:
-    void scanLastOffsets();
-    cFilePlayer(const char* fileName);
-    off_t*      mLastOffsets;
-    int         mLastFileNumber;
-    cFileName  *mRecordingFile;
-    cUnbufferedFile *mCurrentFile;
+    cFilePlayer(cSegmentedFile* File);
+    cSegmentedFile *mFile;
 };
 
 #endif	/* _FILEPLAYER_H */
@@ -0,0 +1,239 @@
+/*
+ * File:   livebuffer.h
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef _LIVEBUFFER_H
+#define	_LIVEBUFFER_H
+
+#include "../common.h"
+#include <stdint.h>
+#include <vdr/thread.h>
+
+#define LIVEBUFFER_INDEPENDENT_FRAME    0x01 ///< the packet starts an independent frame
+
+/**
+ * A broadcast ring buffer for live TV
+ *
+ * This buffer holds transport stream packets in fixed slots. It is written by
+ * exactly one live receiver and read by any number of live streams. Every
+ * packet is copied only once into the buffer and once out of it into the
+ * buffer of the webserver.
+ *
+ * Packets are addressed by sequence numbers, which count the packets since the
+ * buffer was created and never wrap. There are two of them:
+ *
+ * - the \b head is the sequence number of the next packet the receiver puts
+ *   into the buffer,
+ * - \b ready is the sequence number up to which the packets were analyzed by
+ *   the receiver thread. Readers never read beyond it.
+ *
+ * The receiver puts packets without any locks. It never waits for readers. A
+ * reader copies packets and afterwards checks with \c valid() that the writer
+ * did not overwrite them while they were copied. If it did, the reader was
+ * overrun and has to decide what to do, i.e. skip the lost data or give up.
+ *
+ * The size of a buffer is fixed. The receiver resizes its buffer by replacing
+ * it with a new one, which adopts the latest packets of the old buffer with
+ * the same sequence numbers.
+ */
+class cLiveBuffer {
+public:
+    /**
+     * Creates a new live buffer
+     *
+     * The size of the buffer is given in bytes and will be rounded down to
+     * whole transport stream packets.
+     */
+    cLiveBuffer(
+        int Size            ///< the size of the buffer in bytes
+    );
+    virtual ~cLiveBuffer();
+    /**
+     * Adopts the packets of another buffer
+     *
+     * This copies as many of the latest packets and their flags as fit into
+     * this buffer and continues with the sequence numbers of the other
+     * buffer. Readers of the other buffer can continue with this buffer at
+     * their current position, unless it is older than the adopted packets.
+     * The other buffer must not be written meanwhile.
+     */
+    void adopt(
+        const cLiveBuffer* Previous ///< the buffer which is replaced
+    );
+    /**
+     * Puts a packet into the buffer
+     *
+     * This appends a transport stream packet to the buffer. The oldest packet
+     * will be overwritten if the buffer is full. This must only be called by
+     * the one thread writing the buffer.
+     */
+    void put(
+        const uchar* Packet ///< the transport stream packet
+    );
+    /**
+     * Gets a packet
+     *
+     * @return returns the slot of the packet with the sequence number
+     */
+    uchar* packet(uint64_t Sequence) const { return this->mData + (Sequence % this->mPackets) * TS_SIZE; }
+    /**
+     * Gets the flags of a packet
+     *
+     * @return returns the flags of the packet with the sequence number
+     */
+    uchar flags(uint64_t Sequence) const { return this->mFlags[Sequence % this->mPackets]; }
+    /**
+     * Sets the flags of a packet
+     *
+     * This annotates an already received packet, e.g. with
+     * \c LIVEBUFFER_INDEPENDENT_FRAME. It must be called before the packet
+     * is published with \c publish().
+     */
+    void setFlags(uint64_t Sequence, uchar Flags){ this->mFlags[Sequence % this->mPackets] = Flags; }
+    /**
+     * Marks an independent frame
+     *
+     * This sets the flag \c LIVEBUFFER_INDEPENDENT_FRAME on the packet and
+     * remembers it as the start of the latest group of pictures. It must be
+     * called before the packet is published with \c publish().
+     */
+    void markIndependentFrame(
+        uint64_t Sequence   ///< the sequence number of the first packet of the frame
+    );
+    /**
+     * Publishes analyzed packets
+     *
+     * This makes all packets before the given sequence number available for
+     * readers and wakes up all readers waiting for data.
+     */
+    void publish(
+        uint64_t Ready      ///< the sequence number up to which packets are ready
+    );
+    /**
+     * Checks if packets are still valid
+     *
+     * This checks if the packet with the given sequence number and all packets
+     * after it were not overwritten yet. Readers must call this after copying
+     * packets to be sure that the copies are not corrupted.
+     *
+     * @return returns
+     * - \bc true, if the packets are still valid
+     * - \bc false, if the packets were overwritten
+     */
+    bool valid(
+        uint64_t Sequence   ///< the sequence number of the first packet
+    ) const { return Sequence >= this->mFirst && atomicLoad(&this->mHead) - Sequence < (uint64_t)this->mPackets; }
+    /**
+     * Gets the number of packets available
+     *
+     * @return returns
+     * - \bc <0, if the position was overrun by the writer
+     * - \bc the number of packets which can be read from the position, otherwise
+     */
+    int available(
+        uint64_t Position   ///< the sequence number of the next packet to read
+    ) const;
+    /**
+     * Waits for data
+     *
+     * This blocks the caller until at least \c Count packets are available at
+     * the given position. The receiver thread signals waiting readers whenever
+     * new packets were published. The wait ends early if the timeout expires,
+     * the position was overrun or \c wakeup() was called.
+     *
+     * @return returns
+     * - \bc <0, if the position was overrun by the writer
+     * - \bc the number of packets which can be read from the position, otherwise
+     */
+    int wait(
+        uint64_t Position,  ///< the sequence number of the next packet to read
+        int Count,          ///< the number of packets the reader waits for
+        int TimeoutMs       ///< the maximum time to wait in milliseconds
+    );
+    /**
+     * Wakes up all readers
+     *
+     * This wakes up all readers waiting for data, e.g. if the writer is
+     * going to stop.
+     */
+    void wakeup();
+    /**
+     * Gets the write position
+     *
+     * @return returns the sequence number of the next packet put into the buffer
+     */
+    uint64_t head() const { return atomicLoad(&this->mHead); }
+    /**
+     * Gets the read limit
+     *
+     * @return returns the sequence number up to which packets can be read
+     */
+    uint64_t ready() const { return atomicLoad(&this->mReady); }
+    /**
+     * Gets the start of the latest group of pictures
+     *
+     * This returns the position of the latest independent frame, which was
+     * published. A new reader starting there can show a picture immediately
+     * instead of waiting for the next independent frame. If the frame is too
+     * old and is going to be overwritten soon, the read limit is returned.
+     *
+     * @return returns the sequence number where a new reader should start
+     */
+    uint64_t gopStart() const;
+    /**
+     * Gets a position for a reader which was overrun
+     *
+     * This returns a position half the buffer behind the read limit. A reader
+     * which skips to this position has enough data to continue while having
+     * some room before it is overrun again.
+     *
+     * @return returns the sequence number where an overrun reader should continue
+     */
+    uint64_t resync() const;
+    /**
+     * Gets the size of the buffer
+     *
+     * @return returns the number of packets the buffer can hold
+     */
+    int packets() const { return this->mPackets; }
+    /**
+     * Counts the readers
+     *
+     * This adds or removes a reader, which uses the buffer. The count is
+     * changed atomically, so readers need no lock. The owner of the buffer
+     * must not delete the buffer as long as there are readers.
+     */
+    void addReader(int Delta){ __sync_add_and_fetch(&this->mReaders, Delta); }
+    /**
+     * Gets the number of readers
+     *
+     * @return returns the number of readers currently using the buffer
+     */
+    int readers() const { return __sync_add_and_fetch(const_cast<volatile int*>(&this->mReaders), 0); }
+private:
+    static uint64_t atomicLoad(const volatile uint64_t* Value){
+        return __sync_add_and_fetch(const_cast<volatile uint64_t*>(Value), 0);
+    }
+    static void atomicStore(volatile uint64_t* Value, uint64_t NewValue){
+        // A plain store could be torn on 32 bit systems
+        uint64_t OldValue = *Value;
+        while(!__sync_bool_compare_and_swap(Value, OldValue, NewValue)) OldValue = *Value;
+    }
+    uchar*   mData;
+    uchar*   mFlags;
+    int      mPackets;
+    volatile uint64_t mHead;
+    volatile uint64_t mReady;
+    volatile uint64_t mGopStart;
+    uint64_t mFirst;
+    bool     mHasGop;
+    cMutex   mMutex;
+    cCondVar mDataReady;
+    int      mWakeups;
+    volatile int mReaders;
+};
+
+#endif	/* _LIVEBUFFER_H */
@@ -1,22 +1,28 @@
 /*
  * File:   livereceiver.h
  * Author: savop
- *
+ * Author: J.Huber, IRT GmbH
  * Created on 4. Juni 2009, 13:28
+ * Last modification: October 17, 2026
  */
 
 #ifndef _LIVERECEIVER_H
 #define	_LIVERECEIVER_H
 
 #include "../common.h"
-#include "filehandle.h"
+#include "livebuffer.h"
+#include "timeshift.h"
+#include <vector>
 #include <vdr/thread.h>
 #include <vdr/receiver.h>
-#include <vdr/ringbuffer.h>
+#include <vdr/remux.h>
 
-#define RECEIVER_WAIT_ON_NODATA         50 // 50 ms
 #define RECEIVER_WAIT_ON_NODATA_TIMEOUT 1000 * 2 // 2s
 #define RECEIVER_MIN_BUFFER_FILLAGE     20 // 20%
+#define RECEIVER_ANALYZE_WAIT           10 // 10 ms
+#define RECEIVER_ANALYZE_PACKETS        16 // packets the frame detector needs at least
+#define RECEIVER_SIGNAL_PACKETS         32 // wake up the receiver thread every n packets
+#define RECEIVER_CC_UNKNOWN             0xFF // no continuity counter known for a PID
 
 /**
  * A receiver for live TV
@@ -25,44 +31,164 @@
  * It is receiving transport stream packages and generates a single MPEG2
  * transport stream which can be distributed through the network.
  *
+ * There is only one receiver per channel. All clients watching the same
+ * channel share the receiver and read the stream from its broadcast buffer
+ * with their own \c cLiveStream. Receivers are obtained from and released to
+ * \c cLiveReceivers.
+ *
+ * If the device of a receiver stops delivering data or is lost, the watchdog
+ * of \c cLiveReceivers attaches the receiver to another device, see
+ * \c mLiveFailover. The broadcast buffer and the streams are kept, so the
+ * clients only notice a short gap. The continuity counters of the packets
+ * from the new device are restamped to continue those of the old device.
  */
-class cLiveReceiver : public cReceiver, public cThread, public cFileHandle {
+class cLiveReceiver : public cReceiver, public cThread {
+    friend class cLiveReceivers;
 public:
+    virtual ~cLiveReceiver(void);
     /**
-     * Creates a new receiver instance
+     * Acquires the broadcast buffer
      *
-     * This will create a new instance of a live receiver for the specified
-     * channel at the specified priority level.
+     * This returns the buffer which holds the generated transport stream. The
+     * receiver replaces its buffer, when it is resized. The buffer stays valid
+     * until it is released with \c releaseBuffer(). Readers should release it
+     * after each read, so they continue with the new buffer. See also
+     * \c cLiveBufferRef.
      *
-     * A negativ priority means that the receiver may being detached from a
-     * device.
+     * Neither this nor the writer takes a lock. The current buffer is
+     * published with an atomic pointer swap. A replaced buffer is deleted by
+     * the receiver thread, when it has no readers and no reader is about to
+     * acquire it, see \c mAcquiring.
      *
-     * The receiver must be free'd with delete after it is not used any longer.
+     * @return returns the current buffer of the receiver
+     */
+    cLiveBuffer* acquireBuffer();
+    /**
+     * Releases the broadcast buffer
      *
-     * @return returns a new liveReceiver instance
+     * This releases a buffer which was obtained by \c acquireBuffer().
      */
-    static cLiveReceiver* newInstance(
-        cChannel *Channel,      ///< the channel which shall be tuned
-        int Priority            ///< the priority level
+    void releaseBuffer(
+        cLiveBuffer* Buffer     ///< the buffer to release
     );
-    virtual ~cLiveReceiver(void);
-    /*! @copydoc cFileHandle::open(UpnpOpenFileMode) */
-    virtual void open(UpnpOpenFileMode mode);
-    /*! @copydoc cFileHandle::read(char*,size_t) */
-    virtual int read(char* buf, size_t buflen);
-    /*! @copydoc cFileHandle::write(char*,size_t) */
-    virtual int write(char* buf, size_t buflen);
-    /*! @copydoc cFileHandle::seek(off_t,int) */
-    virtual int seek(off_t offset, int whence);
-    /*! @copydoc cFileHandle::close() */
-    virtual void close();
+    /**
+     * Counts an overrun reader
+     *
+     * Streams call this whenever they were overrun by the receiver.
+     */
+    void countOverrun();
+    /**
+     * Gets the bitrate
+     *
+     * @return returns the bitrate of the channel in kbit/s as measured last
+     */
+    int getBitrate() const { return this->mBitrate; }
+    /**
+     * Gets the number of overflows
+     *
+     * @return returns how often the receiver thread fell behind and data was lost
+     */
+    int getOverflows() const { return this->mOverflows; }
+    /**
+     * Gets the peak fill
+     *
+     * @return returns the highest fill level of the buffer with packets not
+     * analyzed yet in percent
+     */
+    int getPeakFill() const { return this->mPeakFill; }
+    /**
+     * Gets the fill
+     *
+     * @return returns the current fill level of the buffer with packets not
+     * analyzed yet in percent
+     */
+    int getFill();
+    /**
+     * Gets the buffer size
+     *
+     * @return returns the current size of the live buffer in bytes
+     */
+    int getBufferSize();
+    /**
+     * Gets the number of overruns
+     *
+     * @return returns how often streams were overrun by the receiver
+     */
+    int getOverruns() const { return this->mOverruns; }
+    /**
+     * Gets the channel
+     *
+     * @return returns the channel which is received
+     */
+    cChannel* getChannel() const { return this->mChannel; }
+    /**
+     * Gets the number of clients
+     *
+     * @return returns the number of streams using this receiver
+     */
+    int getClients() const { return this->mClients; }
+    /**
+     * Gets the PAT and PMT
+     *
+     * This returns the PAT followed by the PMT packets of the generated
+     * transport stream. Streams insert them in front of every independent
+     * frame. The continuity counters are left to the streams.
+     *
+     * @return returns the packets
+     */
+    const uchar* getPatPmt(
+        int &Packets            ///< returns the number of packets
+    ) const { Packets = this->mPatPmtPackets; return this->mPatPmt; }
+    /**
+     * Gets the timeshift file
+     *
+     * @return returns
+     * - \bc the timeshift file of the channel
+     * - \bc NULL, if timeshift is disabled
+     */
+    cTimeshiftFile* getTimeshift() const { return this->mTimeshift; }
+    /**
+     * Checks if the receiver is lost
+     *
+     * A receiver is lost, if it was detached from its device and the watchdog
+     * will not attach it to another one. Streams of a lost receiver end.
+     *
+     * @return returns
+     * - \bc true, if no more data will arrive
+     * - \bc false, otherwise
+     */
+    bool isLost();
+    /**
+     * Checks if the receiver is watched
+     *
+     * The watchdog either restores the data of a watched receiver or gives up
+     * on it, so its streams may wait longer for data than usual.
+     *
+     * @return returns
+     * - \bc true, if the watchdog is enabled and did not give up yet
+     * - \bc false, otherwise
+     */
+    bool isWatched() const;
+    /**
+     * Gets the number of failovers
+     *
+     * @return returns how often the receiver was attached to another device
+     */
+    int getFailovers() const { return this->mFailovers; }
+    /**
+     * Gets the outage time
+     *
+     * @return returns the total time in milliseconds the receiver delivered no
+     * data before the failovers succeeded
+     */
+    uint64_t getOutageTime() const { return this->mOutageTime; }
 protected:
     /**
      * Receives data from VDR
      *
-     * This is the interface for receiving packet data from the VDR. It buffers
-     * the incoming transport stream packets in a linear ringbuffer and returns
-     * immediatelly.
+     * This is the interface for receiving packet data from the VDR. It puts
+     * the incoming transport stream packets into the broadcast buffer and
+     * returns immediatelly.
      */
     virtual void Receive(
         uchar *Data,        ///< The data received from VDR
@@ -84,22 +210,367 @@ protected:
      * The receiver thread action
      *
      * This actually is the receiver thread, which runs consequitivelly and
-     * buffers any received video data from the interal incoming buffer to the
-     * internal outgoing buffer.
-     *
-     * While doing so, it tries to syncronize with the stream and creates new
-     * MPEG2-TS PATs and PMTs for a single MPEG2-TS stream
+     * analyzes the packets in the broadcast buffer. It marks the packets
+     * starting independent frames, where the streams insert the PAT and PMT,
+     * and publishes the analyzed packets to the streams.
      */
     virtual void Action(void);
 private:
-    cLiveReceiver(cChannel *Channel, cDevice *Device);
+    /**
+     * Creates a new receiver instance
+     *
+     * This will create a new instance of a live receiver for the specified
+     * channel at the specified priority level.
+     *
+     * A negativ priority means that the receiver may being detached from a
+     * device.
+     *
+     * A spare receiver is only attached to a device which is neither used for
+     * the live view nor by other receivers. It gets the lowest priority, so
+     * it never stands in the way of any other use of the device.
+     *
+     * @return returns a new liveReceiver instance
+     */
+    static cLiveReceiver* newInstance(
+        cChannel *Channel,      ///< the channel which shall be tuned
+        int Priority,           ///< the priority level
+        bool Spare = false      ///< only use a spare device
+    );
+    cLiveReceiver(cChannel *Channel, cDevice *Device, int Priority = MINPRIORITY);
+    /**
+     * Creates the frame detector
+     *
+     * The frame detector analyzes the video PID or, for radio channels, the
+     * first audio PID.
+     *
+     * @return returns
+     * - \bc true, if the frame detector was created
+     * - \bc false, if the channel has nothing to analyze
+     */
+    bool createFrameDetector();
+    /**
+     * Fails over to another device
+     *
+     * This detaches the receiver from its device and attaches it to another
+     * device which provides the channel without disturbing other receivers
+     * or the live view. The receiver thread restarts with the next packet of
+     * the new device.
+     *
+     * @return returns
+     * - \bc true, if the receiver was attached to another device
+     * - \bc false, if there was none
+     */
+    bool failover();
+    /**
+     * Gives up the receiver
+     *
+     * This detaches the receiver and wakes up its streams, which end.
+     */
+    void giveUp();
+    /**
+     * Restamps the continuity counters
+     *
+     * This continues the continuity counters of the packets before the
+     * failover for the given packet from the new device.
+     */
+    void restamp(
+        uchar* Packet           ///< the transport stream packet
+    );
+    /**
+     * Attaches the receiver
+     *
+     * This allocates the buffers, tunes the device to the channel and attaches
+     * the receiver to it.
+     *
+     * @return returns
+     * - \bc true, if the receiver was attached
+     * - \bc false, otherwise
+     */
+    bool attach();
+    /**
+     * Writes analyzed packets to the timeshift file
+     *
+     * This appends the packets starting at \c mAnalyzed to the timeshift file.
+     * An independent frame is preceded by the PAT and PMT. Packets before the
+     * first independent frame are not written.
+     */
+    void writeTimeshift(
+        bool Independent,       ///< the packets start an independent frame
+        int Packets             ///< the number of packets
+    );
+    /**
+     * Measures the bitrate
+     *
+     * This measures the bitrate of the channel in regular intervals and
+     * resizes the buffer to hold \c RECEIVER_LIVEBUFFER_SECONDS of data
+     * within the configured limits. After an overflow the buffer grows at
+     * once. Retired buffers are deleted as soon as they have no readers.
+     */
+    void measure();
+    /**
+     * Replaces the buffer
+     *
+     * This replaces the buffer with a new one of the given size, which adopts
+     * the latest packets of the current buffer. The new buffer is handed to
+     * the writer in \c mNextBuffer, which adopts the packets and swaps the
+     * buffers before it puts its next packets. Meanwhile the receiver thread
+     * waits and does not touch the buffer. If no packets arrive within
+     * \c RECEIVER_SWAP_TIMEOUT, the buffer is taken back.
+     */
+    void resize(
+        int Size                ///< the new size in bytes
+    );
     cDevice  *mDevice;
     cChannel *mChannel;
-    cRingBufferLinear *mLiveBuffer;
-    cRingBufferLinear *mOutputBuffer;
+    cLiveBuffer* volatile mOutputBuffer;
+    cLiveBuffer* volatile mNextBuffer;
+    volatile int mAcquiring;
     cFrameDetector *mFrameDetector;
     cPatPmtGenerator mPatPmtGenerator;
+    cCondWait mNewData;
+    uint64_t mAnalyzed;
+    int mReceived;
+    int mOverflows;
+    uchar mScratch[RECEIVER_ANALYZE_PACKETS * TS_SIZE];
+    uchar mPatPmt[(MAX_PMT_TS + 1) * TS_SIZE];
+    int mPatPmtPackets;
     int mVType;
+    int mClients;
+    uint64_t mIdleSince;
+    bool mPretuned;
+    cTimeshiftFile *mTimeshift;
+    cVector<cLiveBuffer*> mRetired;
+    volatile uint64_t mReceivedBytes;
+    uint64_t mMeasuredBytes;
+    cTimeMs mMeasureTime;
+    int mBitrate;
+    int mPeakFill;
+    int mMeasuredOverflows;
+    volatile int mOverruns;
+    bool mTimeshiftSynced;
+    uchar mPatCounter;
+    uchar mPmtCounter;
+    int mPriority;
+    bool mLost;
+    bool mAttaching;
+    bool mFailingOver;
+    int mFailoverAttempts;
+    int mFailovers;
+    uint64_t mOutageTime;
+    uint64_t mWatchedBytes;
+    cTimeMs mStalled;
+    cTimeMs mAttempt;
+    bool mRestamp;
+    uchar mNextCounter[MAXPID];
+    uchar mCounterShift[MAXPID];
+};
+
+/**
+ * A reference to the buffer of a live receiver
+ *
+ * This acquires the current buffer of a receiver and releases it again, when
+ * the reference goes out of scope.
+ */
+class cLiveBufferRef {
+public:
+    cLiveBufferRef(cLiveReceiver* Receiver) : mReceiver(Receiver), mBuffer(Receiver->acquireBuffer()){}
+    ~cLiveBufferRef(){ this->mReceiver->releaseBuffer(this->mBuffer); }
+    cLiveBuffer* operator->() const { return this->mBuffer; }
+    operator cLiveBuffer*() const { return this->mBuffer; }
+private:
+    cLiveReceiver* mReceiver;
+    cLiveBuffer*   mBuffer;
+};
+
+/**
+ * The status of a live receiver
+ *
+ * This is a copy of the counters of a receiver, see \c cLiveReceivers::getStatus().
+ */
+struct cLiveReceiverStatus {
+    tChannelID ChannelID;       ///< the channel which is received
+    int Clients;                ///< the number of streams
+    int Bitrate;                ///< the bitrate in kbit/s
+    int BufferSize;             ///< the size of the live buffer in bytes
+    int Fill;                   ///< the fill level of the buffer in percent
+    int PeakFill;               ///< the highest fill level of the buffer in percent
+    int Overflows;              ///< how often the receiver thread fell behind
+    int Overruns;               ///< how often streams were overrun
+};
+
+/**
+ * The live receivers
+ *
+ * This keeps track of the live receivers which are currently in use. A
+ * receiver is shared by all clients which watch the same channel. It is
+ * created with the first client and deleted when the last client has gone.
+ *
+ * If the receiver pool is enabled with \c mLivePoolTime, receivers without
+ * clients stay attached for the configured time. A client switching back to
+ * such a channel is served by the running receiver instead of tuning a
+ * device from scratch. Additionally, the channels next to a watched channel
+ * can be pretuned on spare devices, see \c mLivePretune. The pool thread
+ * pretunes the channels and detaches receivers which were idle for too long.
+ *
+ * The pool thread is the watchdog of the receivers with clients, too. A
+ * receiver which delivered no data for \c mLiveFailover milliseconds or
+ * lost its device fails over to another device. If no other device delivers
+ * data either, the receiver is given up and its streams end.
+ */
+class cLiveReceivers : public cThread {
+public:
+    /**
+     * Get the instance
+     *
+     * @return returns the live receivers instance
+     */
+    static cLiveReceivers* getInstance();
+    /**
+     * Gets a receiver for the channel
+     *
+     * This returns the receiver which is currently receiving the channel. If
+     * there is none, a new receiver will be created and attached to a device.
+     * The new receiver is attached without the lock of the pool, so others
+     * may share it meanwhile. Every receiver obtained with this method must be
+     * released with \c releaseReceiver().
+     *
+     * @return returns
+     * - \bc a receiver for the channel
+     * - \bc NULL, if no device is able to receive the channel
+     */
+    cLiveReceiver* getReceiver(
+        cChannel* Channel,      ///< the channel which shall be tuned
+        int Priority            ///< the priority level
+    );
+    /**
+     * Releases a receiver
+     *
+     * This releases a receiver, which was obtained by \c getReceiver(). If
+     * there are no more clients, the receiver will be detached and deleted.
+     */
+    void releaseReceiver(
+        cLiveReceiver* Receiver ///< the receiver to release
+    );
+    /**
+     * Gets the number of receivers
+     *
+     * @return returns the number of receivers currently in use
+     */
+    int count();
+    /**
+     * Gets the number of idle receivers
+     *
+     * @return returns the number of receivers in the pool which have no clients
+     */
+    int idle();
+    /**
+     * Gets the timeshift window of a channel
+     *
+     * @return returns
+     * - \bc true, if the channel is received with a timeshift file
+     * - \bc false, otherwise
+     */
+    bool getTimeshiftWindow(
+        const tChannelID &ChannelID,    ///< the channel ID
+        uint64_t &Start,                ///< returns the offset of the oldest byte
+        uint64_t &Length                ///< returns the number of bytes written so far
+    );
+    /**
+     * Gets the pool hits
+     *
+     * @return returns the number of clients which were served by an idle receiver
+     */
+    long getHits() const { return this->mHits; }
+    /**
+     * Gets the pool misses
+     *
+     * @return returns the number of clients for which a device had to be tuned
+     */
+    long getMisses() const { return this->mMisses; }
+    /**
+     * Gets the failovers
+     *
+     * @return returns the number of receivers which were attached to another
+     * device by the watchdog
+     */
+    long getFailovers() const { return this->mFailovers; }
+    /**
+     * Gets the failed failovers
+     *
+     * @return returns the number of receivers which were given up, because no
+     * other device delivered data
+     */
+    long getFailedFailovers() const { return this->mFailedFailovers; }
+    /**
+     * Gets the status of the receivers
+     *
+     * This copies the counters of every receiver, including the idle ones.
+     */
+    void getStatus(
+        std::vector<cLiveReceiverStatus> &Status    ///< returns the status of the receivers
+    );
+    /**
+     * Clears the pool
+     *
+     * This stops the pool thread and deletes all receivers without clients.
+     * It is called when the webserver shuts down.
+     */
+    void clear();
+protected:
+    /**
+     * The pool thread action
+     *
+     * This pretunes the requested channels and deletes the receivers which
+     * were idle longer than the configured pool time or lost their device.
+     */
+    virtual void Action(void);
+private:
+    static cLiveReceivers* mInstance;
+    cLiveReceivers();
+    /**
+     * Pretunes the channels next to the given one
+     *
+     * This attaches idle receivers for the adjacent channels to spare
+     * devices. Channels which are received already are skipped. Like in
+     * \c getReceiver(), the receivers are attached without the lock of the
+     * pool, so clients may take them over meanwhile.
+     */
+    void pretune(
+        int Number              ///< the number of the watched channel
+    );
+    /**
+     * Removes expired receivers
+     *
+     * @return returns the number of receivers deleted
+     */
+    int expire();
+    /**
+     * Watches the receivers with clients
+     *
+     * This fails over the receivers which delivered no data for too long.
+     * The receivers are detached and attached to another device without the
+     * lock of the pool, while a reference of the watchdog keeps them.
+     */
+    void watch();
+    /**
+     * Finds the receiver of a channel
+     *
+     * The mutex must be locked by the caller.
+     *
+     * @return returns the attached receiver of the channel or \bc NULL
+     */
+    cLiveReceiver* find(
+        const tChannelID &ChannelID ///< the channel ID
+    );
+    cVector<cLiveReceiver*> mReceivers;
+    cMutex mMutex;
+    cCondWait mWakeup;
+    int mPretuneNumber;
+    long mHits;
+    long mMisses;
+    long mPretunes;
+    long mFailovers;
+    long mFailedFailovers;
 };
 
 #endif	/* _LIVERECEIVER_H */
@@ -0,0 +1,215 @@
+/*
+ * File:   livestream.h
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef _LIVESTREAM_H
+#define	_LIVESTREAM_H
+
+#include "../common.h"
+#include "filehandle.h"
+#include "livereceiver.h"
+#include "pidfilter.h"
+#include <stdint.h>
+#include <vdr/channels.h>
+
+/**
+ * A live TV stream
+ *
+ * This is the file handle of a single client watching live TV. The stream
+ * reads from the broadcast buffer of a shared live receiver. Every stream has
+ * its own read position, so any number of clients can watch the same channel
+ * with only one receiver attached to a device.
+ *
+ * The stream starts with the latest independent frame which is still in the
+ * buffer of the receiver, so a client which joins a running receiver gets a
+ * picture immediately. Otherwise it starts with the next independent frame,
+ * when the receiver has synced to the stream. In front of every
+ * independent frame the PAT and PMT of the receiver are inserted, with
+ * continuity counters of this stream.
+ *
+ * If a client is too slow and the receiver overwrites data which was not yet
+ * read, the configured slow reader policy applies. Either the stream skips the
+ * lost data and continues with the next independent frame or it is aborted.
+ *
+ * If the receiver has a timeshift file, the stream reads from the file
+ * instead. The stream offsets are the offsets in the timeshift file, so
+ * clients can pause the stream and seek within the buffered window. A new
+ * stream starts with the latest independent frame in the file.
+ *
+ * A client may select audio tracks with \c selectAudio(). The stream then only
+ * contains the video and the selected audio tracks and a rewritten PMT.
+ *
+ * Radio channels are announced as audio. Their streams contain the plain MPEG
+ * audio or AAC-ADTS frames of the first audio track instead of a transport
+ * stream, unless \c mRadioTS is set.
+ */
+class cLiveStream : public cFileHandle {
+public:
+    /**
+     * Creates a new live stream
+     *
+     * This will create a new live stream for the specified channel. If the
+     * channel is already received for another client, the receiver will be
+     * shared. Otherwise a new receiver will be attached at the specified
+     * priority level.
+     *
+     * The stream must be free'd with delete after it is not used any longer.
+     *
+     * @return returns
+     * - \bc a new live stream instance
+     * - \bc NULL, if the channel cannot be received
+     */
+    static cLiveStream* newInstance(
+        cChannel *Channel,      ///< the channel which shall be tuned
+        int Priority            ///< the priority level
+    );
+    virtual ~cLiveStream();
+    /*! @copydoc cFileHandle::open(UpnpOpenFileMode) */
+    virtual void open(UpnpOpenFileMode mode);
+    /*! @copydoc cFileHandle::read(char*,size_t) */
+    virtual int read(char* buf, size_t buflen);
+    /*! @copydoc cFileHandle::write(char*,size_t) */
+    virtual int write(char* buf, size_t buflen);
+    /*! @copydoc cFileHandle::seek(off_t,int) */
+    virtual int seek(off_t offset, int whence);
+    /*! @copydoc cFileHandle::close() */
+    virtual void close();
+    /**
+     * Selects audio tracks
+     *
+     * This reduces the stream to the video and the selected audio tracks.
+     * All other elementary streams like further audio tracks, subtitles or
+     * teletext are dropped. The selection is a comma separated list of audio
+     * PIDs or language codes, see \c cPidFilter.
+     *
+     * @return returns
+     * - \bc true, if at least one audio track was selected
+     * - \bc false, if the stream remains unfiltered
+     */
+    bool selectAudio(
+        const char* Selection   ///< the audio PIDs or languages
+    );
+    /**
+     * Gets the time to first byte
+     *
+     * @return returns
+     * - \bc the time in milliseconds from opening the stream until the first
+     *   data was returned
+     * - \bc -1, if no data was returned yet
+     */
+    int getTimeToFirstByte() const { return this->mTimeToFirstByte; }
+    /**
+     * Gets the time spent waiting for data
+     *
+     * @return returns the total time in milliseconds the stream waited for the
+     * receiver to deliver enough data
+     */
+    uint64_t getWaitTime() const { return this->mWaitTime; }
+    /**
+     * Gets the number of waits
+     *
+     * @return returns the number of reads which had to wait for data
+     */
+    long getWaits() const { return this->mWaits; }
+private:
+    cLiveStream(cLiveReceiver* Receiver);
+    /**
+     * Handles an overrun read position
+     *
+     * This applies the slow reader policy after the receiver has overwritten
+     * data which was not read by this stream.
+     *
+     * @return returns
+     * - \bc true, if the stream continues at a new position
+     * - \bc false, if the stream shall be aborted
+     */
+    bool handleOverrun();
+    /**
+     * Leaves the timeshift file
+     *
+     * This lets the stream continue with the latest group of pictures in the
+     * live buffer, after the timeshift file failed.
+     */
+    void leaveTimeshift();
+    /**
+     * Reads from the timeshift file
+     *
+     * @return returns
+     * - \bc TIMESHIFT_ERROR, if the timeshift file failed and the stream
+     *   continues with the live buffer
+     * - \bc <0, in case of another error
+     * - \bc the number of bytes read, otherwise
+     */
+    int readTimeshift(
+        char* buf,              ///< the destination buffer
+        int MaxBytes,           ///< the number of bytes fitting into it
+        int MinBytes            ///< the number of bytes to wait for
+    );
+    /**
+     * Copies packets from the receiver
+     *
+     * This copies the packets which are ready from the broadcast buffer
+     * into the destination buffer. Packets before the first independent frame
+     * are skipped.
+     *
+     * @return returns
+     * - \bc <0, if the packets were overwritten while they were copied
+     * - \bc the number of packets copied, otherwise
+     */
+    int copyPackets(
+        uchar* Dest,            ///< the destination buffer
+        int MaxPackets          ///< the number of packets fitting into it
+    );
+    /**
+     * Filters packets read from the timeshift file
+     *
+     * This drops the packets of the elementary streams which are not selected
+     * and replaces the PMT packets of the receiver with the rewritten PMT.
+     *
+     * @return returns the number of bytes left in the buffer
+     */
+    int filterPackets(
+        uchar* Data,            ///< the packets
+        int Length              ///< the length of the packets in bytes
+    );
+    /**
+     * Extracts the audio frames
+     *
+     * This replaces the transport stream packets with the payload of the audio
+     * PES packets, i.e. the plain audio frames. The output starts with the
+     * first PES packet.
+     *
+     * @return returns the number of bytes left in the buffer
+     */
+    int extractAudio(
+        uchar* Data,            ///< the packets
+        int Length              ///< the length of the packets in bytes
+    );
+    cLiveReceiver* mReceiver;
+    cTimeshiftFile* mTimeshift;
+    uint64_t       mOffset;
+    uint64_t       mPosition;
+    uint64_t       mSyncStart;
+    bool           mSynced;
+    uchar          mPatCounter;
+    uchar          mPmtCounter;
+    cPidFilter*    mPidFilter;
+    uchar          mPatPmt[(MAX_PMT_TS + 1) * TS_SIZE];
+    int            mPatPmtPackets;
+    int            mPmtPid;
+    int            mPmtIndex;
+    int            mAudioPid;
+    bool           mAudioSynced;
+    int            mVType;
+    long           mDroppedBytes;
+    int            mOverruns;
+    uint64_t       mOpenTime;
+    int            mTimeToFirstByte;
+    uint64_t       mWaitTime;
+    long           mWaits;
+};
+
+#endif	/* _LIVESTREAM_H */
@@ -0,0 +1,112 @@
+/*
+ * File:   marktable.h
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef _MARKTABLE_H
+#define	_MARKTABLE_H
+
+#include "../common.h"
+#include <time.h>
+#include <vector>
+#include <string>
+#include <map>
+#include <vdr/recording.h>
+#include <vdr/thread.h>
+
+/**
+ * The marks of a recording
+ *
+ * This holds the frame numbers of the editing marks, which VDR stores in the
+ * file \c marks of a recording, in ascending order. The marks are offered to
+ * the clients as chapters, so they can skip the parts between the marks.
+ */
+class cMarkTable {
+    friend class cMarkTables;
+public:
+    cMarkTable();
+    /**
+     * Gets the number of marks
+     *
+     * @return returns the number of marks
+     */
+    int count() const { return (int)this->mFrames.size(); }
+    /**
+     * Gets the frame of a mark
+     *
+     * @return returns the frame number of the mark
+     */
+    int frame(
+        int Number                  ///< the number of the mark, starting with 1
+    ) const { return this->mFrames[Number-1]; }
+    /**
+     * Gets the time of a mark
+     *
+     * @return returns the normal play time of the mark in seconds
+     */
+    double seconds(
+        int Number                  ///< the number of the mark, starting with 1
+    ) const { return this->mFrames[Number-1] / this->mFramesPerSecond; }
+private:
+    std::vector<int> mFrames;
+    double           mFramesPerSecond;
+    time_t           mModified;
+    int              mPass;
+};
+
+/**
+ * The marks of all recordings
+ *
+ * The mark tables are updated when the recordings are loaded. A table is only
+ * read again, if its file was modified. Recordings without marks have no
+ * table. The tables of deleted recordings are pruned after each pass over the
+ * recordings.
+ */
+class cMarkTables {
+public:
+    /**
+     * Get the instance
+     *
+     * @return returns the mark tables
+     */
+    static cMarkTables* getInstance();
+    /**
+     * Updates the marks of a recording
+     *
+     * This reads the marks file of the recording, if it was modified since it
+     * was read the last time.
+     */
+    void update(
+        const cRecording* Recording ///< the recording
+    );
+    /**
+     * Gets the marks of a recording
+     *
+     * @return returns
+     * - \bc true, if the recording has marks
+     * - \bc false, otherwise
+     */
+    bool get(
+        const char* FileName,       ///< the directory of the recording
+        cMarkTable* Table           ///< the copy of the marks
+    );
+    /**
+     * Removes the marks of deleted recordings
+     *
+     * This removes the tables which were not updated since the last call, so
+     * it must be called after a pass over all recordings.
+     *
+     * @return returns the number of tables removed
+     */
+    int prune();
+private:
+    static cMarkTables* mInstance;
+    cMarkTables();
+    std::map<std::string, cMarkTable> mTables;
+    int mPass;
+    cMutex mMutex;
+};
+
+#endif	/* _MARKTABLE_H */
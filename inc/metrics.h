@@ -0,0 +1,185 @@
+/*
+ * File:   metrics.h
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef _METRICS_H
+#define	_METRICS_H
+
+#include "../common.h"
+#include "filehandle.h"
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vdr/thread.h>
+
+#define METRICS_BUCKETS         10      // the number of buckets of a histogram
+
+/**
+ * A histogram of durations
+ *
+ * The buckets have fixed bounds from 100 microseconds to 5 seconds.
+ */
+class cHistogram {
+public:
+    cHistogram();
+    /**
+     * Counts a duration
+     */
+    void observe(
+        uint64_t Microseconds       ///< the duration
+    );
+    /**
+     * Formats the histogram
+     *
+     * This appends the buckets, the sum and the count of the histogram in the
+     * text format of Prometheus.
+     */
+    void format(
+        std::string &Text,          ///< the text to append to
+        const char* Name,           ///< the name of the metric
+        const char* Labels          ///< the labels, e.g. \c type="recording", or an empty string
+    ) const;
+private:
+    long     mBuckets[METRICS_BUCKETS];
+    long     mCount;
+    uint64_t mSum;
+};
+
+/**
+ * The metrics of an open stream
+ */
+struct cStreamMetrics {
+    unsigned int ResourceID;        ///< the ID of the resource
+    int          ResourceType;      ///< the type of the resource, one of UPNP_RESOURCE_TYPES
+    cFileHandle* FileHandle;        ///< the file handle, which counts the stalls
+    cHistogram   Reads;             ///< the durations of the reads
+    uint64_t     Bytes;             ///< the bytes read
+    long         ReadErrors;        ///< the failed reads
+};
+
+/**
+ * The metrics of the server
+ *
+ * This collects what the server is doing and offers it in the text format
+ * of Prometheus as \c UPNP_DIR_METRICS:
+ * - the open streams by resource type, the bytes they served and the
+ *   durations of their reads
+ * - the same of each open stream, labelled by its resource ID, together with
+ *   the stalls of its reads
+ * - the live receivers, their buffers and overflows
+ * - the recordings, their segment tables and pacing
+ * - the counts and durations of the actions of the content directory
+ * - the durations of the SQLite statements
+ *
+ * The gauges are taken from the other parts of the server, when the text is
+ * requested.
+ */
+class cMetrics {
+public:
+    /**
+     * Get the instance
+     *
+     * @return returns the metrics
+     */
+    static cMetrics* getInstance();
+    /**
+     * Gets the time
+     *
+     * @return returns a monotonic time in microseconds
+     */
+    static uint64_t now();
+    /**
+     * Registers a stream
+     *
+     * The stream gets its own series, until it is closed with
+     * \c closeStream(). Its stalls are taken from the file handle, when the
+     * metrics are requested.
+     *
+     * @return returns the number of the stream
+     */
+    int openStream(
+        unsigned int ResourceID,    ///< the ID of the resource
+        int ResourceType,           ///< the type of the resource, one of UPNP_RESOURCE_TYPES
+        cFileHandle* FileHandle     ///< the file handle of the stream
+    );
+    /**
+     * Removes a stream
+     *
+     * This must be called before the file handle of the stream is deleted.
+     */
+    void closeStream(
+        int Stream                  ///< the number of the stream
+    );
+    /**
+     * Counts a read of a stream
+     */
+    void observeRead(
+        int Stream,                 ///< the number of the stream
+        int ResourceType,           ///< the type of the resource, one of UPNP_RESOURCE_TYPES
+        int Bytes,                  ///< the bytes read or a negative value on errors
+        uint64_t Microseconds       ///< the duration of the read
+    );
+    /**
+     * Counts an action
+     */
+    void observeAction(
+        const char* Action,         ///< the name of the action
+        bool Failed,                ///< the action failed
+        uint64_t Microseconds       ///< the duration of the action
+    );
+    /**
+     * Counts a SQLite statement
+     */
+    void observeStatement(
+        const char* Statement,      ///< the SQL text of the statement
+        uint64_t Microseconds       ///< the duration of the statement
+    );
+    /**
+     * Gets the metrics
+     *
+     * @return returns the metrics in the text format of Prometheus
+     */
+    std::string getText();
+private:
+    static cMetrics* mInstance;
+    cMetrics();
+    cHistogram mReads[UPNP_RESOURCE_URL + 1];
+    uint64_t   mBytes[UPNP_RESOURCE_URL + 1];
+    long       mReadErrors[UPNP_RESOURCE_URL + 1];
+    std::map<int, cStreamMetrics> mStreams;
+    int        mNextStream;
+    std::map<std::string, cHistogram> mActions;
+    std::map<std::string, long> mActionErrors;
+    std::map<std::string, cHistogram> mStatements;
+    cMutex     mMutex;
+};
+
+/**
+ * The metrics file
+ *
+ * This is a file handle, which reads a snapshot of the metrics taken when
+ * it is opened.
+ */
+class cMetricsFile : public cFileHandle {
+public:
+    cMetricsFile();
+    virtual ~cMetricsFile();
+    /*! @copydoc cFileHandle::open(UpnpOpenFileMode) */
+    virtual void open(UpnpOpenFileMode mode);
+    /*! @copydoc cFileHandle::read(char*,size_t) */
+    virtual int read(char* buf, size_t buflen);
+    /*! @copydoc cFileHandle::write(char*,size_t) */
+    virtual int write(char* buf, size_t buflen);
+    /*! @copydoc cFileHandle::seek(off_t,int) */
+    virtual int seek(off_t offset, int origin);
+    /*! @copydoc cFileHandle::close() */
+    virtual void close();
+private:
+    std::string mText;
+    size_t      mPosition;
+};
+
+#endif	/* _METRICS_H */
@@ -0,0 +1,142 @@
+/*
+ * File:   pacer.h
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef _PACER_H
+#define	_PACER_H
+
+#include "../common.h"
+#include <stdint.h>
+#include <vector>
+#include <vdr/thread.h>
+
+/**
+ * A token bucket
+ *
+ * This limits the rate of a single stream. The bucket is filled with the rate
+ * of the stream and every read takes as many tokens as it reads bytes. If the
+ * bucket is empty, the read waits until enough tokens were added.
+ *
+ * The bucket holds the tokens of \c STREAM_PACING_BURST seconds. It is full
+ * when the stream starts and after every seek, so clients can fill their
+ * buffers quickly.
+ */
+class cTokenBucket {
+    friend class cStreamScheduler;
+public:
+    /**
+     * Takes tokens
+     *
+     * This waits until the bucket holds enough tokens and takes them.
+     */
+    void take(
+        size_t Bytes                ///< the number of bytes to read
+    );
+    /**
+     * Fills the bucket
+     *
+     * This allows a burst, e.g. after a seek.
+     */
+    void burst();
+    /**
+     * Gets the rate
+     *
+     * @return returns the rate in bytes per second
+     */
+    double getRate() const { return this->mRate; }
+    /**
+     * Gets the share of the rate
+     *
+     * @return returns the bytes taken per second since the start, relative
+     * to the rate
+     */
+    double getShare() const;
+private:
+    cTokenBucket(double Rate);
+    void refill();
+    double   mRate;
+    double   mCapacity;
+    double   mTokens;
+    uint64_t mLast;
+    uint64_t mStarted;
+    uint64_t mBytes;
+};
+
+/**
+ * The stream scheduler
+ *
+ * This paces the recordings and files which are streamed by the webserver.
+ * Every stream gets a token bucket, which is filled with a multiple of the
+ * average rate of the stream, see \c mPacing. So a client which buffers
+ * aggressively cannot take the whole bandwidth of the disk from the other
+ * streams and the recordings which are made at the same time.
+ *
+ * The fairness of the streams is measured with the index of Jain over the
+ * shares of the streams. It is 1, if all streams get the same share of their
+ * rate, and 1/n, if a single of n streams gets everything.
+ */
+class cStreamScheduler {
+public:
+    /**
+     * Get the instance
+     *
+     * @return returns the stream scheduler
+     */
+    static cStreamScheduler* getInstance();
+    /**
+     * Attaches a stream
+     *
+     * @return returns
+     * - \bc the token bucket of the stream, which must be detached with
+     *   \c detach()
+     * - \bc NULL, if pacing is disabled or the rate is unknown
+     */
+    cTokenBucket* attach(
+        double Rate                 ///< the average rate of the stream in bytes per second
+    );
+    /**
+     * Detaches a stream
+     */
+    void detach(
+        cTokenBucket* Bucket        ///< the token bucket of the stream
+    );
+    /**
+     * Gets the fairness
+     *
+     * @return returns the fairness index of the streams, which is between
+     * 1/n and 1 for n streams
+     */
+    double getFairness();
+    /**
+     * Gets the number of streams
+     *
+     * @return returns the number of paced streams
+     */
+    int getStreams();
+    /**
+     * Gets the number of throttles
+     *
+     * @return returns the number of reads which had to wait for tokens
+     */
+    long getThrottles() const { return this->mThrottles; }
+    /**
+     * Gets the throttle time
+     *
+     * @return returns the total time in milliseconds reads waited for tokens
+     */
+    uint64_t getThrottleTime() const { return this->mThrottleTime; }
+private:
+    friend class cTokenBucket;
+    static cStreamScheduler* mInstance;
+    cStreamScheduler();
+    void throttled(uint64_t Time);
+    std::vector<cTokenBucket*> mBuckets;
+    cMutex   mMutex;
+    long     mThrottles;
+    uint64_t mThrottleTime;
+};
+
+#endif	/* _PACER_H */
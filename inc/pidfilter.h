@@ -0,0 +1,76 @@
+/*
+ * File:   pidfilter.h
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef _PIDFILTER_H
+#define	_PIDFILTER_H
+
+#include "../common.h"
+#include <vdr/channels.h>
+#include <vdr/remux.h>
+
+/**
+ * A PID filter for live streams
+ *
+ * The live receiver forwards all audio, Dolby and subtitle PIDs of a channel,
+ * although most clients play only one audio track. This filter selects the
+ * video and the requested audio tracks of a stream. All other elementary
+ * streams are dropped and the PMT is rewritten to describe only the selected
+ * streams.
+ *
+ * It is derived from \c cPatPmtGenerator to calculate the checksum of the
+ * rewritten PMT the same way as the receiver does.
+ */
+class cPidFilter : public cPatPmtGenerator {
+public:
+    /**
+     * Creates a new PID filter
+     *
+     * The selection is a comma separated list of audio PIDs or language codes,
+     * e.g. \c 1234 or \c deu,eng. A language selects the first audio track of
+     * the channel with this language. MPEG audio is preferred to Dolby.
+     *
+     * @return returns
+     * - \bc a new PID filter
+     * - \bc NULL, if the selection matches no audio track of the channel
+     */
+    static cPidFilter* newInstance(
+        const cChannel* Channel,    ///< the channel of the stream
+        const char* Selection       ///< the selected audio tracks
+    );
+    virtual ~cPidFilter();
+    /**
+     * Checks a PID
+     *
+     * @return returns
+     * - \bc true, if packets with this PID belong to the stream
+     * - \bc false, if they shall be dropped
+     */
+    bool allowed(int Pid) const { return Pid >= 0 && Pid < MAXPID && this->mAllowed[Pid]; }
+    /**
+     * Rewrites the PMT
+     *
+     * This removes all elementary streams which are not selected from the PMT
+     * and recalculates the section length and checksum. The rewritten PMT
+     * never needs more packets than the original one.
+     *
+     * @return returns
+     * - \bc the number of packets of the rewritten PMT
+     * - \bc 0, if the PMT could not be parsed
+     */
+    int rewritePmt(
+        const uchar* Pmt,           ///< the packets of the original PMT
+        int Packets,                ///< the number of packets
+        uchar* Dest                 ///< the destination of the rewritten packets
+    );
+private:
+    cPidFilter();
+    void allow(int Pid);
+    bool mAllowed[MAXPID];
+    int  mAudioTracks;
+};
+
+#endif	/* _PIDFILTER_H */
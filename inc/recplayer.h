@@ -1,8 +1,9 @@
 /* 
  * File:   recplayer.h
  * Author: savop
- *
+ * Author: J.Huber, IRT GmbH
  * Created on 8. Juni 2009, 11:57
+ * Last modification: October 17, 2026
  */
 
 #ifndef _RECPLAYER_H
@@ -10,6 +11,7 @@
 
 #include "../common.h"
 #include "filehandle.h"
+#include "segmentedfile.h"
 #include <vdr/recording.h>
 
 /**
@@ -17,8 +19,19 @@
  *
  * This class provides the ability to play VDR records. The difference between
  * usual files and VDR recording files is, that recordings are possibly splitted
- * into multiple files. The class will scan those files and tries to dynamically
- * navigate in them like it would do, if it is a single file.
+ * into multiple files. The class reads those files with \c cSegmentedFile,
+ * which navigates in them like it would do, if it is a single file.
+ *
+ * A player may start at a normal play time instead of the beginning. The time
+ * is mapped to the independent frame at or before it with the index file of
+ * the recording. The file then appears to start with this frame. It may as
+ * well start at one of the editing marks of the recording.
+ *
+ * A recording which is still written is played in follow mode. At the end of
+ * the data the player waits for the recording to grow, with increasing
+ * delays between the checks, and continues with the new data and segments.
+ * The stream ends, when the recording has finished or did not grow for
+ * \c RECORDING_FOLLOW_TIMEOUT milliseconds.
  *
  */
 class cRecordingPlayer : public cFileHandle {
@@ -39,14 +52,87 @@ public:
     virtual int write(char* buf, size_t buflen);
     virtual int seek(off_t offset, int origin);
     virtual void close();
+    virtual long getStalls() const { return this->mFile->getStalls(); }
+    virtual uint64_t getStallTime() const { return this->mFile->getStallTime(); }
+    /**
+     * Sets the start time
+     *
+     * This lets the file start at the independent frame at or before the
+     * given normal play time. The time is given in seconds, e.g. \c 90.5, or
+     * as hours, minutes and seconds, e.g. \c 0:01:30.5. It must be set
+     * before the player is opened.
+     *
+     * @return returns
+     * - \bc true, if the start was set
+     * - \bc false, if the time is invalid or the recording has no index
+     */
+    bool setStartTime(
+        const char* Npt         ///< the normal play time
+    );
+    /**
+     * Sets the start mark
+     *
+     * This lets the file start at the independent frame at or before the
+     * given editing mark, see \c cMarkTables. It must be set before the
+     * player is opened.
+     *
+     * @return returns
+     * - \bc true, if the start was set
+     * - \bc false, if the recording has no such mark
+     */
+    bool setStartMark(
+        const char* Mark        ///< the number of the mark, starting with 1
+    );
+    /**
+     * Gets the length
+     *
+     * @return returns the number of bytes from the start to the end of the
+     * recording
+     */
+    off_t getLength() const { return this->mFile->size() - this->mStart; }
+    /**
+     * Checks if a recording is still written
+     *
+     * A recording is written as long as its index grows. This is safe to call
+     * from any thread.
+     *
+     * @return returns
+     * - \bc true, if the index was written within the last
+     *   \c RECORDING_INDEX_TIMEOUT seconds
+     * - \bc false, otherwise
+     */
+    static bool isRecording(
+        const cRecording* Recording ///< the recording
+    );
+    /**
+     * Parses a normal play time
+     *
+     * The time is given in seconds, e.g. \c 90.5, or as hours, minutes and
+     * seconds, e.g. \c 0:01:30.5.
+     *
+     * @return returns
+     * - \bc true, if the time is valid
+     * - \bc false, otherwise
+     */
+    static bool parseTime(
+        const char* Npt,        ///< the normal play time
+        double* Seconds         ///< the time in seconds
+    );
 private:
-    void scanLastOffsets();
-    cRecordingPlayer(cRecording *Recording);
-    off_t*      mLastOffsets;
-    int         mLastFileNumber;
+    cRecordingPlayer(cRecording *Recording, cSegmentedFile* File);
+    /**
+     * Sets the start frame
+     *
+     * @return returns
+     * - \bc true, if the start was set at the frame or the independent frame
+     *   before it
+     * - \bc false, if the recording has no index
+     */
+    bool setStartFrame(int Frame);
+    off_t       mStart;
+    bool        mFollow;
     cRecording *mRecording;
-    cFileName  *mRecordingFile;
-    cUnbufferedFile *mCurrentFile;
+    cSegmentedFile *mFile;
 };
 
 #endif	/* _RECPLAYER_H */
@@ -3,7 +3,7 @@
  * Author: savop
  * Author: J.Huber, IRT GmbH
  * Created on 30. September 2009, 15:17
- * Last modification: April 9, 2013
+ * Last modification: October 17, 2026
  */
 
 #ifndef _RESOURCES_H
@@ -12,7 +12,11 @@
 #include "object.h"
 #include <vdr/channels.h>
 #include <vdr/recording.h>
+#include <vdr/thread.h>
 #include <pthread.h>
+#include <map>
+#include <deque>
+#include <vector>
 
 class cUPnPResourceMediator;
 class cMediaDatabase;
@@ -25,6 +29,7 @@ class cMediaDatabase;
 class cUPnPResource : public cListObject {
     friend class cUPnPResourceMediator;
     friend class cUPnPResources;
+    friend class cResourceCache;
 private:
     unsigned int mResourceID;
     int     mResourceType;
@@ -33,6 +38,7 @@ private:
     cString mResolution;
     cString mProtocolInfo;
     cString mContentType;
+    cString mContentFeatures;
     cString mImportURI;
     off64_t mSize;
     unsigned int mBitrate;
@@ -43,7 +49,12 @@ private:
     int mRecordTimer;
     int mObjectId;
 	bool mCacheAdded;
+    bool mCacheOwned;
+    volatile int mReferences;
+    int mDlnaOperation;
+    unsigned int mDlnaFlags;
     cUPnPResource();
+    void initContentFeatures();
 
 public:
     /**
@@ -95,6 +106,32 @@ public:
      * @return the content type of the resource
      */
     const char* getContentType() const { return this->mContentType; }
+    /**
+     * Get the content features
+     *
+     * Returns the value of the \c contentFeatures.dlna.org header of a stream
+     * of the resource. It is computed once, when the resource is created or
+     * loaded.
+     *
+     * @return the content features of the resource
+     */
+    const char* getContentFeatures() const { return this->mContentFeatures; }
+    /**
+     * Get the DLNA operation
+     *
+     * Returns the seek operations of a stream of the resource.
+     *
+     * @return the DLNA operation of the resource
+     */
+    int         getDlnaOperation() const { return this->mDlnaOperation; }
+    /**
+     * Get the DLNA flags
+     *
+     * Returns the DLNA flags of a stream of the resource.
+     *
+     * @return the DLNA flags of the resource
+     */
+    unsigned int getDlnaFlags() const { return this->mDlnaFlags; }
     /**
      * Get the import URI
      *
@@ -226,6 +263,116 @@ class cUPnPClassItem;
 class cUPnPClassVideoItem;
 class cUPnPClassVideoBroadcast;
 
+/**
+ * The resource cache
+ *
+ * This finds the resources by their IDs without the database, so the webserver
+ * can start a stream while the EPG is written to the database.
+ *
+ * The cache is split by the resource IDs into \c RESOURCE_CACHE_STRIPES
+ * stripes with a read/write lock each. Lookups run in parallel and only wait
+ * for a resource which is added to the same stripe at the same time.
+ *
+ * Only the resources of EPG items are evicted, the oldest first, if a stripe
+ * holds more than its share of \c RESOURCE_CACHE_EPG_ENTRIES of them. An
+ * evicted resource stays with its object.
+ *
+ * The resources are counted. The cache holds a reference of every cached
+ * resource and every lookup takes another one, which the caller gives back
+ * with \c release(). A resource which the cache loaded itself and which no
+ * object took over is deleted with its last reference.
+ */
+class cResourceCache {
+public:
+    cResourceCache();
+    virtual ~cResourceCache();
+    /**
+     * Gets a resource
+     *
+     * This takes a reference of the resource, which must be given back with
+     * \c release().
+     *
+     * @return returns
+     * - \bc the cached resource
+     * - \bc NULL, if the resource is not cached
+     */
+    cUPnPResource* get(
+        unsigned int ResourceID     ///< the ID of the resource
+    );
+    /**
+     * Releases a resource
+     *
+     * This gives back a reference of a resource. A resource which belongs to
+     * the cache is deleted with its last reference.
+     */
+    void release(
+        cUPnPResource* Resource     ///< the resource
+    );
+    /**
+     * Adds a resource
+     *
+     * The cache takes a reference of the resource. A cached resource with
+     * the same ID is replaced.
+     */
+    void add(
+        cUPnPResource* Resource     ///< the resource
+    );
+    /**
+     * Removes a resource
+     *
+     * The resource is not deleted, it belongs to its object.
+     */
+    void remove(
+        cUPnPResource* Resource     ///< the resource
+    );
+    /**
+     * Hands a resource over to an object
+     *
+     * The cache does not delete a resource which belongs to an object.
+     */
+    void adopt(
+        cUPnPResource* Resource     ///< the resource
+    );
+    /**
+     * Gets the number of resources
+     *
+     * @return returns the number of cached resources
+     */
+    int getCount();
+    /**
+     * Gets the number of hits
+     *
+     * @return returns the number of lookups which found the resource
+     */
+    long getHits() const { return this->mHits; }
+    /**
+     * Gets the number of misses
+     *
+     * @return returns the number of lookups which had to load the resource
+     */
+    long getMisses() const { return this->mMisses; }
+    /**
+     * Gets the number of evictions
+     *
+     * @return returns the number of resources of EPG items which were evicted
+     */
+    long getEvictions() const { return this->mEvictions; }
+private:
+    struct cStripe {
+        cRwLock mLock;
+        std::map<unsigned int, cUPnPResource*> mEntries;
+        std::deque<unsigned int> mEpgEntries;  ///< the IDs of the EPG resources in the order they were added
+        int mEpgCount;
+        cStripe() : mEpgCount(0) {}
+    };
+    cStripe* stripeOf(unsigned int ResourceID);
+    void evict(cStripe* Stripe, std::vector<cUPnPResource*>& Evicted);
+    cStripe mStripes[RESOURCE_CACHE_STRIPES];
+    long mHits;
+    long mMisses;
+    long mEvictions;
+};
+
 /**
  * The resource manager
  *
@@ -234,7 +381,7 @@ class cUPnPClassVideoBroadcast;
  */
 class cUPnPResources {
 private:
-    cHash<cUPnPResource>*        mResources;
+    cResourceCache*              mResources;
     static cUPnPResources*       mInstance;
     cUPnPResourceMediator*       mMediator;
     cSQLiteDatabase*             mDatabase;
@@ -244,6 +391,12 @@ private:
 	 * @param resource the pointer to the resource to be added
 	 */
 	void addCache(cUPnPResource* resource);
+    /**
+     * Get a resource for an object
+     *
+     * The object takes over the resource.
+     */
+    cUPnPResource* adoptResource(unsigned int ResourceID);
 public:
     /**
      * Fill object with its resources
@@ -267,8 +420,46 @@ public:
      * - \bc <0, otherwise
      */
     int loadResources();
-    /*! @copydoc cUPnPResourceMediator::getResource */
+    /**
+     * Loads the resources of a type into the cache
+     *
+     * This is done at startup for the channels, so the first live stream
+     * does not wait for the database.
+     *
+     * @return returns
+     * - \bc the number of loaded resources
+     * - \bc <0, in case of an error
+     */
+    int preloadResources(
+        int ResourceType            ///< the resource type, see \c UPNP_RESOURCE_TYPES
+    );
+    /**
+     * Gets the cache
+     *
+     * @return returns the resource cache
+     */
+    cResourceCache* getCache() const { return this->mResources; }
+    /**
+     * Get a resource
+     *
+     * This looks the resource up in the cache and loads it from the database
+     * if it is not cached. The resource must be released with
+     * \c releaseResource(), see also \c cUPnPResourceRef.
+     *
+     * @param ResourceID the ID of the resource
+     * @return returns
+     * - \bc the resource
+     * - \bc NULL, if there is no such resource
+     */
     cUPnPResource* getResource(unsigned int ResourceID);
+    /**
+     * Release a resource
+     *
+     * This releases a resource obtained by \c getResource().
+     *
+     * @param Resource the resource
+     */
+    void releaseResource(cUPnPResource* Resource);
     virtual ~cUPnPResources();
     /**
      * Get the instance of the resource manager.
@@ -347,6 +538,24 @@ public:
     virtual int deleteCachedResources(cUPnPClassObject* delObject);
 };
 
+/**
+ * A reference to a resource
+ *
+ * This gets a resource from the resource manager and releases it again, when
+ * the reference goes out of scope.
+ */
+class cUPnPResourceRef {
+public:
+    cUPnPResourceRef(unsigned int ResourceID) : mResource(cUPnPResources::getInstance()->getResource(ResourceID)){}
+    ~cUPnPResourceRef(){ if(this->mResource) cUPnPResources::getInstance()->releaseResource(this->mResource); }
+    cUPnPResource* operator->() const { return this->mResource; }
+    operator cUPnPResource*() const { return this->mResource; }
+private:
+    cUPnPResourceRef(const cUPnPResourceRef&);
+    cUPnPResourceRef& operator=(const cUPnPResourceRef&);
+    cUPnPResource* mResource;
+};
+
 /**
  * The resource mediator
  *
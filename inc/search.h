@@ -1,8 +1,9 @@
 /* 
  * File:   search.h
  * Author: savop
- *
+ * Author: J.Huber, IRT GmbH
  * Created on 27. August 2009, 21:21
+ * Last modification: October 17, 2026
  */
 
 #ifndef _SEARCH_H
@@ -11,6 +12,7 @@
 #include <map>
 #include <vdr/tools.h>
 #include "util.h"
+#include "../common.h"
 
 /**
  * Sort criteria
@@ -25,6 +27,35 @@ struct cSortCrit : public cListObject {
 
 typedef std::map<const char*, const char*, strCmp> propertyMap;
 
+/**
+ * A parsed web path
+ *
+ * This holds the section, the method and the properties of a path parsed by
+ * \c cPathParser::parseFast(). The keys and values point into the buffer of the
+ * structure, so it needs no memory from the heap and may live on the stack.
+ */
+struct cWebPath {
+    int         Section;                                ///< the number of the registered section
+    int         Method;                                 ///< the number of the registered method
+    int         Count;                                  ///< the number of properties
+    const char* Keys[WEB_PATH_MAX_PROPERTIES];          ///< the keys of the properties
+    const char* Values[WEB_PATH_MAX_PROPERTIES];        ///< the values of the properties
+    char        Buffer[WEB_PATH_MAX_LENGTH];            ///< the properties, separated by null characters
+    /**
+     * Gets a property
+     *
+     * If a key is given more than once, the last value is returned like
+     * in a \c propertyMap.
+     *
+     * @return returns
+     * - \bc the value of the property
+     * - \bc NULL, if the path has no such property
+     */
+    const char* get(
+        const char* Key             ///< the key of the property
+    ) const;
+};
+
 /**
  * Web path parser
  *
@@ -62,6 +93,22 @@ public:
         int* Method,                ///< the number of the registered method
         propertyMap* Properties     ///< the properties found in the path
     );
+    /**
+     * Parses the path quickly
+     *
+     * This parses the same paths as \c parse(), but without the grammar
+     * and without allocating any memory. It is used for every request of the
+     * webserver. Paths with a query longer than \c WEB_PATH_MAX_LENGTH or with
+     * more than \c WEB_PATH_MAX_PROPERTIES properties are rejected.
+     *
+     * @return returns
+     * - \bc true, if the parsing was successful
+     * - \bc false, otherwise
+     */
+    static bool parseFast(
+        const char* Path,           ///< the path which is parsed
+        cWebPath* Result            ///< the parsed path
+    );
 };
 
 /**
@@ -0,0 +1,436 @@
+/*
+ * File:   segmentedfile.h
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef _SEGMENTEDFILE_H
+#define	_SEGMENTEDFILE_H
+
+#include "../common.h"
+#include <stdint.h>
+#include <time.h>
+#include <vector>
+#include <string>
+#include <map>
+#include <vdr/thread.h>
+
+/**
+ * The segment table of a recording
+ *
+ * This holds the names and the end offsets of the segments of a recording.
+ * The table is shared by all streams of the recording and never changes once
+ * it was scanned. If the recording changes, a new table replaces it in the
+ * cache, while the streams which use the old table keep it until they end.
+ */
+class cSegmentTable {
+    friend class cSegmentTables;
+public:
+    /**
+     * Gets the number of segments
+     *
+     * @return returns the number of the last segment
+     */
+    int segments() const { return (int)this->mNames.size(); }
+    /**
+     * Gets the size
+     *
+     * @return returns the size of all segments together
+     */
+    off_t size() const { return this->mEnds.back(); }
+    /**
+     * Gets the start of a segment
+     *
+     * @return returns the offset of the first byte of the segment
+     */
+    off_t start(int Number) const { return this->mEnds[Number-1]; }
+    /**
+     * Gets the end of a segment
+     *
+     * @return returns the offset behind the last byte of the segment
+     */
+    off_t end(int Number) const { return this->mEnds[Number]; }
+    /**
+     * Gets the file name of a segment
+     *
+     * @return returns the path of the segment
+     */
+    const char* name(int Number) const { return this->mNames[Number-1].c_str(); }
+    /**
+     * Gets the path
+     *
+     * @return returns the directory of the recording
+     */
+    const char* path() const { return this->mPath.c_str(); }
+    /**
+     * Checks the format
+     *
+     * @return returns
+     * - \bc true, if the recording consists of PES files
+     * - \bc false, if it consists of TS files
+     */
+    bool isPesRecording() const { return this->mPesRecording; }
+    /**
+     * Gets the segment of an offset
+     *
+     * This searches the segment which contains the given offset. The end of
+     * the file belongs to the last segment.
+     *
+     * @return returns the number of the segment, starting with 1
+     */
+    int segmentOf(
+        off_t Offset                ///< the offset in the file
+    ) const;
+private:
+    cSegmentTable(const char* FileName);
+    /**
+     * Scans the segments
+     *
+     * This determines the sizes of the segment files with \c stat(), without
+     * opening them.
+     *
+     * @return returns
+     * - \bc true, if there was at least one segment
+     * - \bc false, otherwise
+     */
+    bool scan(
+        bool IsPesRecording         ///< the recording consists of PES files
+    );
+    /**
+     * Checks if the table is up to date
+     *
+     * A table is up to date, if neither the directory nor the last segment
+     * were modified since the scan. Checks within \c SEGMENT_TABLE_TTL
+     * milliseconds after the last one are skipped.
+     *
+     * @return returns
+     * - \bc true, if the recording did not change
+     * - \bc false, otherwise
+     */
+    bool fresh();
+    std::string              mPath;
+    std::vector<std::string> mNames;
+    std::vector<off_t>       mEnds;
+    time_t   mDirectoryTime;
+    time_t   mLastTime;
+    uint64_t mChecked;
+    int      mRefs;
+    bool     mCached;
+    bool     mPesRecording;
+};
+
+/**
+ * The segment table cache
+ *
+ * This keeps the segment tables of the recordings which were played lately,
+ * so opening a recording again needs no scan of its segments. Tables are
+ * reference counted. Unused tables are dropped, if the cache holds more than
+ * \c SEGMENT_TABLE_CACHE tables.
+ */
+class cSegmentTables {
+public:
+    /**
+     * Get the instance
+     *
+     * @return returns the segment table cache
+     */
+    static cSegmentTables* getInstance();
+    /**
+     * Acquires the table of a recording
+     *
+     * This returns the cached table of the recording, if it is up to date.
+     * Otherwise the segments are scanned. Every table must be released with
+     * \c release().
+     *
+     * @return returns
+     * - \bc the segment table
+     * - \bc NULL, if the recording has no segments
+     */
+    cSegmentTable* acquire(
+        const char* FileName,       ///< the directory of the recording
+        bool IsPesRecording         ///< the recording consists of PES files
+    );
+    /**
+     * Releases a table
+     */
+    void release(
+        cSegmentTable* Table        ///< the table to release
+    );
+    /**
+     * Gets the hits
+     *
+     * @return returns the number of recordings opened without a scan
+     */
+    long getHits() const { return this->mHits; }
+    /**
+     * Gets the misses
+     *
+     * @return returns the number of recordings which had to be scanned
+     */
+    long getMisses() const { return this->mMisses; }
+    /**
+     * Gets the number of stalls
+     *
+     * @return returns the number of reads of all recordings which stalled
+     */
+    long getStalls() const { return this->mStalls; }
+    /**
+     * Gets the stall time
+     *
+     * @return returns the total time in milliseconds of the reads of all
+     * recordings which stalled
+     */
+    uint64_t getStallTime() const { return this->mStallTime; }
+private:
+    friend class cSegmentedFile;
+    static cSegmentTables* mInstance;
+    cSegmentTables();
+    void trim();
+    void stalled(uint64_t Time);
+    std::map<std::string, cSegmentTable*> mTables;
+    cMutex mMutex;
+    long   mHits;
+    long   mMisses;
+    long   mStalls;
+    uint64_t mStallTime;
+};
+
+/**
+ * The aligned buffers for direct reads
+ *
+ * Direct reads need buffers which are aligned to \c DIRECT_IO_ALIGNMENT.
+ * This pool keeps up to \c DIRECT_IO_POOL buffers which are not used by a
+ * stream, so they are not allocated again for every stream.
+ */
+class cAlignedBuffers {
+public:
+    /**
+     * Get the instance
+     *
+     * @return returns the buffer pool
+     */
+    static cAlignedBuffers* getInstance();
+    /**
+     * Gets a buffer
+     *
+     * @return returns
+     * - \bc a buffer of \c DIRECT_IO_BUFFER bytes
+     * - \bc NULL, if no memory is left
+     */
+    char* get();
+    /**
+     * Returns a buffer
+     */
+    void put(
+        char* Buffer                ///< the buffer
+    );
+private:
+    static cAlignedBuffers* mInstance;
+    cAlignedBuffers(){}
+    std::vector<char*> mBuffers;
+    cMutex mMutex;
+};
+
+/**
+ * A segmented file
+ *
+ * VDR splits recordings into the files \c 00001.ts, \c 00002.ts and so on.
+ * This class presents these segments as one file with one continuous range of
+ * byte offsets.
+ *
+ * Reads go with \c pread() straight from the segment into the buffer of the
+ * caller, which is the send buffer of the webserver. A read which reaches the
+ * end of a segment continues with the next one, so the buffer is always filled
+ * completely, except at the end of the file. Only the segment which is read
+ * currently is open.
+ *
+ * The kernel is asked to read the configured window ahead of the position,
+ * see \c mReadAhead, so the data is in the page cache when the webserver
+ * asks for it. The window reaches into the next segment, which is opened
+ * early for this. A seek discards the window and starts a new one at the
+ * new position. Reads which still had to wait for the disk are counted as
+ * stalls.
+ *
+ * With \c mDirectIO the segments are opened with \c O_DIRECT and read in
+ * aligned blocks of \c DIRECT_IO_BUFFER bytes into a buffer from
+ * \c cAlignedBuffers, from where the requested bytes are copied. Reads and
+ * seeks within the block which was read last need no further access to the
+ * disk. The read-ahead is disabled then. File systems which do not support
+ * \c O_DIRECT are read through the page cache as usual.
+ */
+class cSegmentedFile {
+public:
+    /**
+     * Creates a new segmented file
+     *
+     * This gets the segment table of the recording in the given directory
+     * from \c cSegmentTables.
+     *
+     * @return returns
+     * - \bc a new segmented file
+     * - \bc NULL, if there is no segment
+     */
+    static cSegmentedFile* newInstance(
+        const char* FileName,       ///< the directory of the recording
+        bool IsPesRecording         ///< the recording consists of PES files
+    );
+    virtual ~cSegmentedFile();
+    /**
+     * Reads data
+     *
+     * This reads data at the current position and advances the position.
+     *
+     * @return returns
+     * - \bc <0, in case of an error
+     * - \bc 0, at the end of the file
+     * - \bc the number of bytes read, otherwise
+     */
+    int read(
+        char* Dest,                 ///< the destination buffer
+        size_t Length               ///< the size of the buffer
+    );
+    /**
+     * Gets the length of a read of whole packets
+     *
+     * This shortens a read, so it ends with a whole transport stream packet.
+     * After a seek into a packet, the next read completes this packet.
+     *
+     * @return returns the number of bytes to read
+     */
+    size_t packetLength(
+        size_t Length               ///< the size of the buffer
+    ) const;
+    /**
+     * Sets the position
+     *
+     * @return returns
+     * - \bc true, if the position is within the file
+     * - \bc false, otherwise
+     */
+    bool seek(
+        off_t Position              ///< the offset in the file
+    );
+    /**
+     * Gets the position
+     *
+     * @return returns the offset of the next byte to read
+     */
+    off_t position() const { return this->mPosition; }
+    /**
+     * Gets the size
+     *
+     * @return returns the size of all segments together
+     */
+    off_t size() const { return this->mTable->size(); }
+    /**
+     * Gets the number of segments
+     *
+     * @return returns the number of the last segment
+     */
+    int segments() const { return this->mTable->segments(); }
+    /**
+     * Gets the offset of a position in a segment
+     *
+     * @return returns
+     * - \bc the offset in the whole file
+     * - \bc -1, if there is no such segment
+     */
+    off_t offsetOf(
+        int Number,                 ///< the number of the segment, starting with 1
+        off_t Offset                ///< the offset in the segment
+    ) const;
+    /**
+     * Closes the file
+     *
+     * This closes the current segment. It is opened again with the next read.
+     */
+    void close();
+    /**
+     * Refreshes the segments
+     *
+     * This gets the current segment table of a recording which is still
+     * written, so new data and new segments become readable.
+     *
+     * @return returns
+     * - \bc true, if the file has grown
+     * - \bc false, otherwise
+     */
+    bool refresh();
+    /**
+     * Sets the read-ahead window
+     *
+     * Streams which jump through the file, like trick play, read only small
+     * parts of it and must not ask the kernel for the data in between.
+     */
+    void setReadAhead(
+        off_t Bytes                 ///< the size of the window, 0 disables it
+    ) { this->mReadAhead = Bytes; }
+    /**
+     * Gets the number of stalls
+     *
+     * @return returns the number of reads which took at least
+     * \c STREAM_STALL_THRESHOLD milliseconds
+     */
+    long getStalls() const { return this->mStalls; }
+    /**
+     * Gets the stall time
+     *
+     * @return returns the total time in milliseconds of the reads which stalled
+     */
+    uint64_t getStallTime() const { return this->mStallTime; }
+    /**
+     * Gets the number of bytes read
+     *
+     * @return returns the number of bytes read since the file was created
+     */
+    uint64_t getBytesRead() const { return this->mBytesRead; }
+private:
+    cSegmentedFile(cSegmentTable* Table);
+    bool openSegment(int Number);
+    /**
+     * Reads from the current segment
+     *
+     * @return returns
+     * - \bc <0, in case of an error
+     * - \bc 0, at the end of the segment
+     * - \bc the number of bytes read, otherwise
+     */
+    ssize_t readSegment(
+        char* Dest,                 ///< the destination buffer
+        size_t Length,              ///< the number of bytes to read
+        off_t Offset                ///< the offset in the segment
+    );
+    /**
+     * Reads ahead
+     *
+     * This advises the kernel to read the window ahead of the current
+     * position. The window is only extended after half of it was read, to
+     * keep the number of system calls low.
+     */
+    void readAhead();
+    /**
+     * Opens a segment for the read-ahead
+     *
+     * @return returns the file descriptor or -1
+     */
+    int openAhead(int Number);
+    cSegmentTable* mTable;
+    off_t mPosition;
+    int   mNumber;
+    int   mFile;
+    int   mAheadNumber;
+    int   mAheadFile;
+    off_t mReadAhead;
+    off_t mAdvised;
+    long  mStalls;
+    uint64_t mStallTime;
+    uint64_t mBytesRead;
+    char* mDirectBuffer;
+    bool  mDirect;
+    int   mBufferNumber;
+    off_t mBufferStart;
+    off_t mBufferLength;
+};
+
+#endif	/* _SEGMENTEDFILE_H */
@@ -0,0 +1,218 @@
+/*
+ * File:   timeshift.h
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef _TIMESHIFT_H
+#define	_TIMESHIFT_H
+
+#include "../common.h"
+#include <stdint.h>
+#include <vdr/thread.h>
+#include <vdr/channels.h>
+#include <vdr/ringbuffer.h>
+
+#define TIMESHIFT_OVERRUN       -1      // the offset has fallen out of the window
+#define TIMESHIFT_ERROR         -2      // the file could not be written or read
+
+/**
+ * A timeshift ring file for live TV
+ *
+ * This file holds the last minutes of a live channel on disk. It is written by
+ * the live receiver of the channel and read by all its live streams, so
+ * clients can pause the stream or seek back within the buffered window.
+ *
+ * The data is addressed by byte offsets, which count the bytes since the
+ * receiver started and never wrap. The file holds the latest bytes up to its
+ * size, i.e. the window from \c start() to \c length(). The beginning of the
+ * window moves as soon as the file is full.
+ *
+ * The written transport stream is playable on its own. Every independent
+ * frame is preceded by the PAT and PMT.
+ *
+ * The data is written to disk by a thread of its own, which is fed through a
+ * ring buffer, so a slow disk does not hold up the live receiver. If the ring
+ * buffer runs full, the data up to the next independent frame is dropped.
+ *
+ * The file is unlinked right after it was created, so it disappears with the
+ * receiver, even if VDR crashes.
+ */
+class cTimeshiftFile : public cThread {
+public:
+    /**
+     * Creates a new timeshift file
+     *
+     * This creates a timeshift file for the channel in the configured
+     * timeshift directory. The size is given in bytes and will be rounded
+     * down to whole transport stream packets.
+     *
+     * @return returns
+     * - \bc a new timeshift file
+     * - \bc NULL, if the file could not be created
+     */
+    static cTimeshiftFile* newInstance(
+        const cChannel* Channel,    ///< the channel which is recorded
+        off64_t Size                ///< the size of the file in bytes
+    );
+    virtual ~cTimeshiftFile();
+    /**
+     * Writes data
+     *
+     * This queues data for the writer thread, which appends it to the file.
+     * The oldest data will be overwritten if the file is full. The data is not
+     * visible to readers until it was published with \c publish(). This must
+     * only be called by the one thread feeding the file.
+     *
+     * @return returns
+     * - \bc true, if the data was queued
+     * - \bc false, if an error occured or the data was dropped
+     */
+    bool write(
+        const uchar* Data,          ///< the transport stream packets
+        int Length                  ///< the length of the data in bytes
+    );
+    /**
+     * Marks an independent frame
+     *
+     * This remembers the current write position as the start of the latest
+     * group of pictures. It must be called before the PAT and PMT in front of
+     * the frame are written. Data is queued again from here on, if it was
+     * dropped before.
+     */
+    void markIndependentFrame();
+    /**
+     * Publishes written data
+     *
+     * This makes all queued data available for readers, as soon as the writer
+     * thread has written it, and wakes up all readers waiting for data.
+     */
+    void publish();
+    /**
+     * Reads data
+     *
+     * This reads published data at the given offset. If the data was
+     * overwritten, because the offset has fallen out of the window, the
+     * reader was overrun.
+     *
+     * @return returns
+     * - \bc TIMESHIFT_OVERRUN, if the offset was overrun by the writer
+     * - \bc TIMESHIFT_ERROR, if the file could not be written or read
+     * - \bc the number of bytes read, otherwise
+     */
+    int read(
+        uint64_t Offset,            ///< the offset of the data
+        uchar* Dest,                ///< the destination buffer
+        int Length                  ///< the size of the destination buffer
+    );
+    /**
+     * Gets the number of bytes available
+     *
+     * @return returns
+     * - \bc TIMESHIFT_OVERRUN, if the offset was overrun by the writer
+     * - \bc TIMESHIFT_ERROR, if the file could not be written or read
+     * - \bc the number of bytes which can be read at the offset, otherwise
+     */
+    int available(
+        uint64_t Offset             ///< the offset of the next byte to read
+    );
+    /**
+     * Waits for data
+     *
+     * This blocks the caller until at least \c Bytes bytes are available at
+     * the given offset. The wait ends early if the timeout expires, the offset
+     * was overrun or \c wakeup() was called.
+     *
+     * @return returns
+     * - \bc TIMESHIFT_OVERRUN, if the offset was overrun by the writer
+     * - \bc TIMESHIFT_ERROR, if the file could not be written or read
+     * - \bc the number of bytes which can be read at the offset, otherwise
+     */
+    int wait(
+        uint64_t Offset,            ///< the offset of the next byte to read
+        int Bytes,                  ///< the number of bytes the reader waits for
+        int TimeoutMs               ///< the maximum time to wait in milliseconds
+    );
+    /**
+     * Wakes up all readers
+     *
+     * This wakes up all readers waiting for data, e.g. if the writer is
+     * going to stop.
+     */
+    void wakeup();
+    /**
+     * Gets the start of the window
+     *
+     * @return returns the offset of the oldest byte which can be read
+     */
+    uint64_t start();
+    /**
+     * Gets the end of the window
+     *
+     * @return returns the number of bytes published so far
+     */
+    uint64_t length();
+    /**
+     * Gets the start of the latest group of pictures
+     *
+     * @return returns the offset of the PAT in front of the latest independent
+     * frame or the end of the window, if there was none
+     */
+    uint64_t gopStart();
+    /**
+     * Gets a position for a reader which was overrun
+     *
+     * This returns a position a quarter of the file after the start of the
+     * window. A reader which continues there has some room before it is
+     * overrun again.
+     *
+     * @return returns the offset where an overrun reader should continue
+     */
+    uint64_t resync();
+protected:
+    /**
+     * Writes the queued data
+     *
+     * This writes the data of the ring buffer to the file and publishes it,
+     * until the file is deleted or a write failed.
+     */
+    virtual void Action(void);
+private:
+    cTimeshiftFile(int File, off64_t Size);
+    /**
+     * Writes data to the file
+     *
+     * @return returns
+     * - \bc true, if the data was written
+     * - \bc false, if an error occured
+     */
+    bool store(const uchar* Data, int Length);
+    /**
+     * Publishes the stored data
+     *
+     * This publishes the data which was published by the receiver and is
+     * stored in the file. The mutex must be locked.
+     */
+    void publishStored();
+    int bytesAvailable(uint64_t Offset) const;
+    uint64_t windowStart() const;
+    int      mFile;
+    off64_t  mSize;
+    cRingBufferLinear* mRing;
+    uint64_t mQueued;
+    uint64_t mWritten;
+    uint64_t mStored;
+    uint64_t mPublishable;
+    uint64_t mPublished;
+    uint64_t mGopStart;
+    bool     mHasGop;
+    bool     mFailed;
+    bool     mDropping;
+    int      mDrops;
+    cMutex   mMutex;
+    cCondVar mDataReady;
+    int      mWakeups;
+};
+
+#endif	/* _TIMESHIFT_H */
@@ -0,0 +1,143 @@
+/*
+ * File:   trickplayer.h
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef _TRICKPLAYER_H
+#define	_TRICKPLAYER_H
+
+#include "../common.h"
+#include "filehandle.h"
+#include "segmentedfile.h"
+#include <vdr/recording.h>
+#include <vdr/remux.h>
+
+/**
+ * The trick play player
+ *
+ * This plays a recording fast forward or backward. The stream consists only
+ * of the independent frames of the video, which are looked up in the index
+ * file of the recording and copied without transcoding. The frames are
+ * \c TRICK_FRAME_RATE per second apart at normal speed, multiplied by the
+ * speed. So only a few percent of the recording are read, even at high
+ * speeds.
+ *
+ * Every frame is preceded by the PAT and PMT of the recording. The packets of
+ * all other elementary streams are dropped and the continuity counters are
+ * rewritten, so the stream has no gaps. The time stamps remain unchanged.
+ *
+ * The stream has no length and cannot be seeked. A forward stream starts at
+ * the beginning, a backward stream at the end of the recording, unless a
+ * start time is set.
+ */
+class cTrickPlayer : public cFileHandle {
+public:
+    /**
+     * Get a new instance of a trick play player
+     *
+     * @return returns
+     * - \bc a new trick play player
+     * - \bc NULL, if the speed is invalid or the recording has no index
+     */
+    static cTrickPlayer* newInstance(
+        cRecording* Recording,      ///< the recording to play
+        const char* Speed           ///< the speed, e.g. \c 8 or \c -16
+    );
+    virtual ~cTrickPlayer();
+    /*! @copydoc cFileHandle::open(UpnpOpenFileMode) */
+    virtual void open(UpnpOpenFileMode mode);
+    /*! @copydoc cFileHandle::read(char*,size_t) */
+    virtual int read(char* buf, size_t buflen);
+    /*! @copydoc cFileHandle::write(char*,size_t) */
+    virtual int write(char* buf, size_t buflen);
+    /*! @copydoc cFileHandle::seek(off_t,int) */
+    virtual int seek(off_t offset, int origin);
+    /*! @copydoc cFileHandle::close() */
+    virtual void close();
+    /*! @copydoc cFileHandle::getStalls() */
+    virtual long getStalls() const { return this->mFile->getStalls(); }
+    /*! @copydoc cFileHandle::getStallTime() */
+    virtual uint64_t getStallTime() const { return this->mFile->getStallTime(); }
+    /**
+     * Sets the start time
+     *
+     * This lets the stream start at the independent frame at or before the
+     * given normal play time, see \c cRecordingPlayer::parseTime(). It must be
+     * set before the player is opened.
+     *
+     * @return returns
+     * - \bc true, if the start was set
+     * - \bc false, if the time is invalid
+     */
+    bool setStartTime(
+        const char* Npt             ///< the normal play time
+    );
+    /**
+     * Parses a speed
+     *
+     * The speed is a whole number up to \c TRICK_MAX_SPEED. Negative speeds
+     * play backward. The normal speed 1 is no trick play.
+     *
+     * @return returns
+     * - \bc the speed
+     * - \bc 0, if the speed is invalid
+     */
+    static int parseSpeed(
+        const char* Speed           ///< the speed
+    );
+private:
+    cTrickPlayer(cRecording* Recording, cSegmentedFile* File, cIndexFile* Index, int Speed);
+    /**
+     * Reads the PAT and PMT
+     *
+     * This collects the PAT and PMT packets at the beginning of the recording
+     * and determines the video PID.
+     *
+     * @return returns
+     * - \bc true, if the recording has a video stream
+     * - \bc false, otherwise
+     */
+    bool readPatPmt();
+    /**
+     * Loads the next frame
+     *
+     * This reads the next independent frame into the buffer and drops the
+     * packets which do not belong to the video.
+     *
+     * @return returns
+     * - \bc true, if a frame was loaded
+     * - \bc false, at the end of the recording
+     */
+    bool loadFrame();
+    /**
+     * Appends a packet to the buffer
+     *
+     * This sets the continuity counter of the packet to the next one of its
+     * PID in the stream.
+     */
+    void appendPacket(
+        const uchar* Packet         ///< the packet
+    );
+    cRecording*     mRecording;
+    cSegmentedFile* mFile;
+    cIndexFile*     mIndex;
+    int             mSpeed;
+    int             mStep;
+    int             mFrame;
+    int             mStart;
+    uchar           mPatPmt[(MAX_PMT_TS + 1) * TS_SIZE];
+    int             mPatPmtPackets;
+    int             mPmtPid;
+    int             mVpid;
+    uchar*          mBuffer;
+    int             mLength;
+    int             mOffset;
+    off_t           mPosition;
+    uchar           mPatCounter;
+    uchar           mPmtCounter;
+    uchar           mVideoCounter;
+};
+
+#endif	/* _TRICKPLAYER_H */
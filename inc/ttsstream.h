@@ -0,0 +1,98 @@
+/*
+ * File:   ttsstream.h
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef _TTSSTREAM_H
+#define	_TTSSTREAM_H
+
+#include "../common.h"
+#include "filehandle.h"
+#include <stdint.h>
+#include <vdr/remux.h>
+
+/**
+ * A timestamped transport stream
+ *
+ * This turns the transport stream of another file handle into a DLNA
+ * timestamped transport stream. Every packet is preceded by four bytes with
+ * its arrival time in units of the 27 MHz system clock, so renderers can pace
+ * the playback like a broadcast.
+ *
+ * The arrival times are taken from the program clock references of the
+ * stream. The packets between two references get times which increase
+ * steadily with the rate of the last interval.
+ *
+ * The offsets of the stream are \c TTS_SIZE bytes per packet. A seek goes to
+ * the packet which contains the offset.
+ */
+class cTimestampedStream : public cFileHandle {
+public:
+    /**
+     * Creates a timestamped stream
+     *
+     * The stream takes over the given file handle and deletes it with itself.
+     */
+    cTimestampedStream(
+        cFileHandle* Stream         ///< the transport stream
+    );
+    virtual ~cTimestampedStream();
+    /*! @copydoc cFileHandle::open(UpnpOpenFileMode) */
+    virtual void open(UpnpOpenFileMode mode);
+    /*! @copydoc cFileHandle::read(char*,size_t) */
+    virtual int read(char* buf, size_t buflen);
+    /*! @copydoc cFileHandle::write(char*,size_t) */
+    virtual int write(char* buf, size_t buflen);
+    /*! @copydoc cFileHandle::seek(off_t,int) */
+    virtual int seek(off_t offset, int origin);
+    /*! @copydoc cFileHandle::close() */
+    virtual void close();
+    /*! @copydoc cFileHandle::getStalls() */
+    virtual long getStalls() const { return this->mStream->getStalls(); }
+    /*! @copydoc cFileHandle::getStallTime() */
+    virtual uint64_t getStallTime() const { return this->mStream->getStallTime(); }
+    /**
+     * Gets the length of a timestamped stream
+     *
+     * @return returns
+     * - \bc the length of the timestamped stream
+     * - \bc -1, if the length of the transport stream is unknown
+     */
+    static off_t lengthOf(
+        off_t Length                ///< the length of the transport stream
+    );
+private:
+    /**
+     * Fills the output buffer
+     *
+     * @return returns
+     * - \bc <0, in case of an error
+     * - \bc 0, at the end of the stream
+     * - \bc the number of bytes in the output buffer, otherwise
+     */
+    int fill();
+    /**
+     * Gets the arrival time of a packet
+     *
+     * @return returns the arrival time in units of the 27 MHz clock
+     */
+    uint64_t timestamp(
+        const uchar* Packet         ///< the packet
+    );
+    cFileHandle* mStream;
+    uchar    mPackets[TTS_PACKETS * TS_SIZE];
+    int      mPartial;
+    uchar    mOutput[TTS_PACKETS * TTS_SIZE];
+    int      mLength;
+    int      mOffset;
+    int      mSkip;
+    off_t    mPosition;
+    int      mPcrPid;
+    uint64_t mLastPcr;
+    uint64_t mTicksPerPacket;
+    int      mSincePcr;
+};
+
+#endif	/* _TTSSTREAM_H */
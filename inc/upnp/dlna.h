@@ -1,8 +1,9 @@
 /* 
  * File:   dlna.h
  * Author: savop
- *
+ * Author: J.Huber, IRT GmbH
  * Created on 18. April 2009, 23:27
+ * Last modification: October 17, 2026
  */
 
 #ifndef _DLNA_H
@@ -86,6 +87,23 @@ public:
         int Ci = -1,                ///< conversion indication flag
         unsigned int Flags = 0      ///< DLNA flags
     );
+    /**
+     * Content features
+     *
+     * Writes the fourth field of a protocol info into a buffer. It is sent as
+     * \c contentFeatures.dlna.org header with a stream, too.
+     *
+     * @return the buffer
+     */
+    static const char* getContentFeatures(
+        char* Buffer,               ///< the buffer, which should hold \c DLNA_MAX_PROTOCOL_INFO characters
+        size_t Size,                ///< the size of the buffer
+        const char* ProfileID,      ///< the DLNA profile ID or NULL, if the profile is unknown
+        int Op = -1,                ///< operation mode
+        const char* Ps = NULL,      ///< play speed (CSV list)
+        int Ci = -1,                ///< conversion indication flag
+        unsigned int Flags = 0      ///< DLNA flags
+    );
 private:
     cDlna();
     void init(void);
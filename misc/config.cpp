@@ -3,7 +3,7 @@
  * Author: savop
  * author: J.Huber, IRT GmbH
  * Created on 15. August 2009, 13:03
- * Last modification: February 7, 2013
+ * Last modification: October 17, 2026
  */
 
 #include <stdio.h>
@@ -31,6 +31,21 @@ cUPnPConfig::cUPnPConfig(){
 	this->mChangeRadioClass = false;
 	this->mEpgPreviewDays = 7;            // default value
 	this->mFirstChannelsAmount = 0;       // take all channels
+	this->mLiveSlowReader = RECEIVER_SLOW_READER_DROP;
+	this->mLivePoolTime = 0;
+	this->mLivePretune = 0;
+	this->mLiveTimeshift = 0;
+	this->mLiveTimeshiftDir = NULL;
+	this->mLiveBufferMin = RECEIVER_LIVEBUFFER_MIN;
+	this->mLiveBufferMax = RECEIVER_LIVEBUFFER_MAX;
+	this->mLiveFailover = RECEIVER_FAILOVER_TIMEOUT;
+	this->mRadioTS = false;
+	this->mReadAhead = STREAM_READ_AHEAD;
+	this->mPacing = STREAM_PACING;
+	this->mDirectIO = false;
+	this->mTimestampedTS = false;
+	this->mMaxStreams = STREAM_MAX;
+	this->mMaxStreamsPerResource = STREAM_MAX_PER_RESOURCE;
 	this->mEpgFile = strdup("epg.data");  // see also DEFAULTEPGDATAFILENAME in vdr.c
 }
 
@@ -68,6 +83,21 @@ bool cUPnPConfig::processArgs(int argc, char* argv[]){
 		{"without_ca", no_argument,    NULL, 'W'},
         {"httpdir", required_argument, NULL, 0},
         {"dbdir",   required_argument, NULL, 0},
+        {"slowreader", required_argument, NULL, 0},
+        {"pooltime", required_argument, NULL, 0},
+        {"pretune", required_argument, NULL, 0},
+        {"timeshift", required_argument, NULL, 0},
+        {"timeshiftdir", required_argument, NULL, 0},
+        {"livebufmin", required_argument, NULL, 0},
+        {"livebufmax", required_argument, NULL, 0},
+        {"radiots", no_argument,       NULL, 0},
+        {"failover", required_argument, NULL, 0},
+        {"readahead", required_argument, NULL, 0},
+        {"pacing", required_argument, NULL, 0},
+        {"directio", no_argument,      NULL, 0},
+        {"tts", no_argument,           NULL, 0},
+        {"maxstreams", required_argument, NULL, 0},
+        {"maxperresource", required_argument, NULL, 0},
         {0, 0, 0, 0}
     };
 
@@ -172,6 +202,51 @@ bool cUPnPConfig::processArgs(int argc, char* argv[]){
                 else if(!strcasecmp("dbdir", opt->name)){
                     success = this->parseSetup(SETUP_DATABASE_DIR, optarg) && success;
                 }
+                else if(!strcasecmp("slowreader", opt->name)){
+                    success = this->parseSetup(SETUP_LIVE_SLOW_READER, optarg) && success;
+                }
+                else if(!strcasecmp("pooltime", opt->name)){
+                    success = this->parseSetup(SETUP_LIVE_POOL_TIME, optarg) && success;
+                }
+                else if(!strcasecmp("pretune", opt->name)){
+                    success = this->parseSetup(SETUP_LIVE_PRETUNE, optarg) && success;
+                }
+                else if(!strcasecmp("timeshift", opt->name)){
+                    success = this->parseSetup(SETUP_LIVE_TIMESHIFT, optarg) && success;
+                }
+                else if(!strcasecmp("timeshiftdir", opt->name)){
+                    success = this->parseSetup(SETUP_LIVE_TIMESHIFT_DIR, optarg) && success;
+                }
+                else if(!strcasecmp("livebufmin", opt->name)){
+                    success = this->parseSetup(SETUP_LIVE_BUFFER_MIN, optarg) && success;
+                }
+                else if(!strcasecmp("livebufmax", opt->name)){
+                    success = this->parseSetup(SETUP_LIVE_BUFFER_MAX, optarg) && success;
+                }
+                else if(!strcasecmp("radiots", opt->name)){
+                    this->mRadioTS = true;
+                }
+                else if(!strcasecmp("failover", opt->name)){
+                    success = this->parseSetup(SETUP_LIVE_FAILOVER, optarg) && success;
+                }
+                else if(!strcasecmp("readahead", opt->name)){
+                    success = this->parseSetup(SETUP_READ_AHEAD, optarg) && success;
+                }
+                else if(!strcasecmp("pacing", opt->name)){
+                    success = this->parseSetup(SETUP_STREAM_PACING, optarg) && success;
+                }
+                else if(!strcasecmp("directio", opt->name)){
+                    this->mDirectIO = true;
+                }
+                else if(!strcasecmp("tts", opt->name)){
+                    this->mTimestampedTS = true;
+                }
+                else if(!strcasecmp("maxstreams", opt->name)){
+                    success = this->parseSetup(SETUP_STREAM_MAX, optarg) && success;
+                }
+                else if(!strcasecmp("maxperresource", opt->name)){
+                    success = this->parseSetup(SETUP_STREAM_MAX_PER_RESOURCE, optarg) && success;
+                }
                 break;
             default:
                 return false;
@@ -220,6 +295,51 @@ bool cUPnPConfig::parseSetup(const char *Name, const char *Value)
 	else if (!strcasecmp(Name, SETUP_EPG_DATA_FILE)){
 		this->mEpgFile = strdup0(Value);
 	}
+	else if (!strcasecmp(Name, SETUP_LIVE_SLOW_READER)){
+		if (!strcasecmp(Value, "drop") || !strcmp(Value, "0")){
+			this->mLiveSlowReader = RECEIVER_SLOW_READER_DROP;
+		}
+		else if (!strcasecmp(Value, "disconnect") || !strcmp(Value, "1")){
+			this->mLiveSlowReader = RECEIVER_SLOW_READER_DISCONNECT;
+		}
+		else {
+			ERROR("Unknown slow reader policy '%s', use 'drop' or 'disconnect'", Value);
+			return false;
+		}
+	}
+	else if (!strcasecmp(Name, SETUP_LIVE_POOL_TIME)){
+		this->mLivePoolTime = max(0, atoi(Value));
+	}
+	else if (!strcasecmp(Name, SETUP_LIVE_PRETUNE)){
+		this->mLivePretune = max(0, atoi(Value));
+	}
+	else if (!strcasecmp(Name, SETUP_LIVE_TIMESHIFT_DIR)){
+		this->mLiveTimeshiftDir = strdup0(Value);
+	}
+	else if (!strcasecmp(Name, SETUP_LIVE_TIMESHIFT)){
+		this->mLiveTimeshift = max(0, atoi(Value));
+	}
+	else if (!strcasecmp(Name, SETUP_LIVE_BUFFER_MIN)){
+		this->mLiveBufferMin = max(16, atoi(Value));
+	}
+	else if (!strcasecmp(Name, SETUP_LIVE_BUFFER_MAX)){
+		this->mLiveBufferMax = max(16, atoi(Value));
+	}
+	else if (!strcasecmp(Name, SETUP_LIVE_FAILOVER)){
+		this->mLiveFailover = max(0, atoi(Value));
+	}
+	else if (!strcasecmp(Name, SETUP_READ_AHEAD)){
+		this->mReadAhead = max(0, atoi(Value));
+	}
+	else if (!strcasecmp(Name, SETUP_STREAM_PACING)){
+		this->mPacing = max(0, atoi(Value));
+	}
+	else if (!strcasecmp(Name, SETUP_STREAM_MAX)){
+		this->mMaxStreams = min(UPNP_WEB_MAX_FILE_HANDLES, max(1, atoi(Value)));
+	}
+	else if (!strcasecmp(Name, SETUP_STREAM_MAX_PER_RESOURCE)){
+		this->mMaxStreamsPerResource = max(1, atoi(Value));
+	}
     else{
 		return false;
 	}
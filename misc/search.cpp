@@ -1,8 +1,9 @@
 /*
  * File:   search.cpp
  * Author: savop
- *
+ * Author: J.Huber, IRT GmbH
  * Created on 27. August 2009, 21:21
+ * Last modification: October 17, 2026
  */
 
 // uncomment this to enable debuging of the grammar
@@ -727,7 +728,7 @@ struct cPathParserGrammar : public boost::spirit::grammar<cPathParserGrammar> {
             value               = (*uncriticalChar)[self.pushPropertyValue]
                                   ;
 
-            uncriticalChar      = chset_p("-_.%~0-9A-Za-z")
+            uncriticalChar      = chset_p("-_.%~,:0-9A-Za-z")
                                   ;
         }
     };
@@ -812,4 +813,104 @@ void cPathParser::pushMethod(int Method){
 void cPathParser::pushSection(int Section){
     MESSAGE(VERBOSE_PARSERS, "Pushing section '%d'", Section);
     this->mSection = Section;
+}
+
+ /**********************************************\
+ *                                              *
+ *  The fast pathparser                         *
+ *                                              *
+ \**********************************************/
+
+/** @private */
+static const struct {
+    const char* Name;
+    int         Method;
+} WebserverMethodNames[] = {
+    { "browse", UPNP_WEB_METHOD_BROWSE },
+    { "download", UPNP_WEB_METHOD_DOWNLOAD },
+    { "search", UPNP_WEB_METHOD_SEARCH },
+    { "show", UPNP_WEB_METHOD_SHOW },
+    { "get", UPNP_WEB_METHOD_STREAM },
+    { NULL, 0 }
+};
+
+// The same characters as alnum_p and uncriticalChar of the grammar
+static inline bool isKeyChar(char c){
+    return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+static inline bool isValueChar(char c){
+    return isKeyChar(c) || c == '-' || c == '_' || c == '.' || c == '%' || c == '~' || c == ',' || c == ':';
+}
+
+const char* cWebPath::get(const char* Key) const {
+    for(int i = this->Count - 1; i >= 0; i--){
+        if(!strcmp(this->Keys[i], Key)){
+            return this->Values[i];
+        }
+    }
+    return NULL;
+}
+
+bool cPathParser::parseFast(const char* Path, cWebPath* Result){
+    if(!Path){
+        return false;
+    }
+    // The only section is the shares directory
+    size_t Length = strlen(UPNP_DIR_SHARES);
+    if(strncmp(Path, UPNP_DIR_SHARES, Length) || Path[Length] != '/'){
+        ERROR("Parsing path failed");
+        return false;
+    }
+    const char* Method = Path + Length + 1;
+    const char* Query = strchr(Method, '?');
+    Result->Method = -1;
+    for(int i = 0; Query && WebserverMethodNames[i].Name; i++){
+        if(strlen(WebserverMethodNames[i].Name) == (size_t)(Query - Method) &&
+           !strncmp(Method, WebserverMethodNames[i].Name, Query - Method)){
+            Result->Method = WebserverMethodNames[i].Method;
+        }
+    }
+    if(Result->Method < 0){
+        ERROR("Parsing path failed");
+        return false;
+    }
+    Length = strlen(++Query);
+    if(Length >= sizeof(Result->Buffer)){
+        ERROR("Parsing path failed, the query is too long");
+        return false;
+    }
+    memcpy(Result->Buffer, Query, Length + 1);
+    Result->Section = 0;
+    Result->Count = 0;
+    // The properties are split in place: key=value&key=value
+    char* Position = Result->Buffer;
+    while(true){
+        char* Key = Position;
+        while(isKeyChar(*Position)) Position++;
+        if(Position == Key || *Position != '='){
+            ERROR("Parsing path failed");
+            return false;
+        }
+        *Position++ = 0;
+        char* Value = Position;
+        while(isValueChar(*Position)) Position++;
+        if(Result->Count == WEB_PATH_MAX_PROPERTIES){
+            ERROR("Parsing path failed, too many properties");
+            return false;
+        }
+        Result->Keys[Result->Count] = Key;
+        Result->Values[Result->Count] = Value;
+        Result->Count++;
+        if(!*Position){
+            break;
+        }
+        if(*Position != '&'){
+            ERROR("Parsing path failed");
+            return false;
+        }
+        *Position++ = 0;
+    }
+    MESSAGE(VERBOSE_PARSERS, "Parse path successful");
+    return true;
 }
\ No newline at end of file
@@ -3,7 +3,7 @@
  * Author: J.Huber, IRT GmbH
  * 
  * Created on Jule 3, 2012
- * Last modification: April 9, 2013
+ * Last modification: October 17, 2026
  */
 
 #include <stdio.h>
@@ -13,26 +13,23 @@
 #include "fileplayer.h"
 
 cFilePlayer *cFilePlayer::newInstance(const char* fileName){
-    cFilePlayer *Player = new cFilePlayer(fileName);
+    cSegmentedFile* File = cSegmentedFile::newInstance(fileName, false);
+    if(!File){
+        return NULL;
+    }
+    cFilePlayer *Player = new cFilePlayer(File);
     return Player;
 }
 cFilePlayer::~cFilePlayer() {
-    delete this->mRecordingFile;
-    delete [] this->mLastOffsets;
+    delete this->mFile;
 }
 
-cFilePlayer::cFilePlayer(const char* fileName)  {
+cFilePlayer::cFilePlayer(cSegmentedFile* File) : mFile(File) {
     MESSAGE(VERBOSE_SDK, "Created FilePlayer");
-
-    this->mRecordingFile = new cFileName(/*this->mRecording->FileName()*/(char*)fileName, false, false, false);
-    this->mLastOffsets = new off_t[VDR_MAX_FILES_PER_TSRECORDING+1];
-    this->scanLastOffsets();
 }
 
 void cFilePlayer::open(UpnpOpenFileMode){
-    // Open() does not work?!
-    this->mCurrentFile = this->mRecordingFile->SetOffset(1);
-    if(this->mCurrentFile){
+    if(this->mFile->seek(0)){
         MESSAGE(VERBOSE_RECORDS, "File player opened");
     }
     else {
@@ -41,7 +38,7 @@ void cFilePlayer::open(UpnpOpenFileMode){
 }
 
 void cFilePlayer::close(){
-    this->mRecordingFile->Close();
+    this->mFile->close();
 }
 
 int cFilePlayer::write(char*, size_t){
@@ -50,39 +47,21 @@ int cFilePlayer::write(char*, size_t){
 }
 
 int cFilePlayer::read(char* buf, size_t buflen){
-    if(!this->mCurrentFile){
-        ERROR("Current part of record is not open");
-        return -1;
-    }
     MESSAGE(VERBOSE_RECORDS, "Reading %d from record", buflen);
-    int bytesread = 0;
-    while((bytesread = this->mCurrentFile->Read(buf, buflen)) == 0){ // EOF, try next file
-        if(!(this->mCurrentFile = this->mRecordingFile->NextFile())){
-            // no more files to read... finished!
-            break;
-        }
-    }
-    return bytesread;
+    // The segments are read straight into the buffer of the webserver
+    return this->mFile->read(buf, this->mFile->packetLength(buflen));
 }
 
 int cFilePlayer::seek(off_t offset, int origin){
-    if(!this->mCurrentFile){
-        ERROR("Current part of record is not open");
-        return -1;
-    }
-    
     MESSAGE(VERBOSE_RECORDS, "Seeking...");
 
-    off_t relativeOffset = 0;
-    off_t curpos = this->mCurrentFile->Seek(0, SEEK_CUR); // this should not change anything
-    int index;
     // recalculate the absolute position in the record
     switch(origin){
         case SEEK_END:
-            offset = this->mLastOffsets[this->mLastFileNumber] + offset;
+            offset = this->mFile->size() + offset;
             break;
         case SEEK_CUR:
-            offset = this->mLastOffsets[this->mRecordingFile->Number()-1] + curpos +  offset;
+            offset = this->mFile->position() + offset;
             break;
         case SEEK_SET:
             // Nothing to change
@@ -91,29 +70,9 @@ int cFilePlayer::seek(off_t offset, int origin){
             ERROR("Seek operation invalid");
             return -1;
     }
-    // finally, we can seek
-    // TODO: binary search
-    for(index = 1; this->mLastOffsets[index]; index++){
-        if(this->mLastOffsets[index-1] <= offset && offset <= this->mLastOffsets[index]){
-            relativeOffset = offset - this->mLastOffsets[index-1];
-            break;
-        }
-    }
-    if(!(this->mCurrentFile = this->mRecordingFile->SetOffset(index, relativeOffset))){
-        // seeking failed!!! should never happen.
-        this->mCurrentFile = this->mRecordingFile->SetOffset(1);
+    if(!this->mFile->seek(offset)){
+        ERROR("Seek position %lld is out of the record", (long long)offset);
         return -1;
     }
-
     return 0;
 }
-
-void cFilePlayer::scanLastOffsets(){
-    // rewind
-    this->mCurrentFile = this->mRecordingFile->SetOffset(1);
-    for(int i = 1; (this->mCurrentFile = this->mRecordingFile->NextFile()); i++){
-        this->mLastOffsets[i] = this->mLastOffsets[i-1] + this->mCurrentFile->Seek(0, SEEK_END);
-        this->mLastFileNumber = this->mRecordingFile->Number();
-    }
-}
-
@@ -0,0 +1,124 @@
+/*
+ * File:   livebuffer.cpp
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#include <vdr/thread.h>
+#include "livebuffer.h"
+
+cLiveBuffer::cLiveBuffer(int Size){
+    this->mPackets = Size / TS_SIZE;
+    this->mData = MALLOC(uchar, this->mPackets * TS_SIZE);
+    this->mFlags = MALLOC(uchar, this->mPackets);
+    this->mHead = 0;
+    this->mReady = 0;
+    this->mGopStart = 0;
+    this->mHasGop = false;
+    this->mWakeups = 0;
+    this->mReaders = 0;
+    this->mFirst = 0;
+    if(!this->mData || !this->mFlags){
+        ERROR("Failed to allocate %d packets for the live buffer", this->mPackets);
+        free(this->mData); this->mData = NULL;
+        free(this->mFlags); this->mFlags = NULL;
+        this->mPackets = 0;
+    }
+    else {
+        memset(this->mFlags, 0, this->mPackets);
+    }
+}
+
+cLiveBuffer::~cLiveBuffer(){
+    free(this->mData);
+    free(this->mFlags);
+}
+
+void cLiveBuffer::adopt(const cLiveBuffer* Previous){
+    if(!this->mData || !Previous->mPackets) return;
+
+    uint64_t Head = Previous->head();
+    uint64_t Count = (uint64_t)min(this->mPackets, Previous->mPackets);
+    uint64_t First = Head > Count ? Head - Count : 0;
+    for(uint64_t Sequence = First; Sequence < Head; Sequence++){
+        memcpy(this->packet(Sequence), Previous->packet(Sequence), TS_SIZE);
+        this->mFlags[Sequence % this->mPackets] = Previous->flags(Sequence);
+    }
+    // Older sequence numbers were never in this buffer
+    this->mFirst = First;
+    this->mHead = Head;
+    this->mReady = Previous->ready();
+    this->mGopStart = Previous->mGopStart;
+    this->mHasGop = Previous->mHasGop && Previous->mGopStart >= First;
+}
+
+void cLiveBuffer::put(const uchar* Packet){
+    if(!this->mData) return;
+
+    // Only this thread modifies the head, so reading it needs no barrier
+    uint64_t Head = this->mHead;
+    int Slot = (int)(Head % this->mPackets);
+    this->mFlags[Slot] = 0;
+    memcpy(this->mData + Slot * TS_SIZE, Packet, TS_SIZE);
+    atomicStore(&this->mHead, Head + 1);
+}
+
+void cLiveBuffer::markIndependentFrame(uint64_t Sequence){
+    this->mFlags[Sequence % this->mPackets] |= LIVEBUFFER_INDEPENDENT_FRAME;
+    atomicStore(&this->mGopStart, Sequence);
+    this->mHasGop = true;
+}
+
+void cLiveBuffer::publish(uint64_t Ready){
+    cMutexLock MutexLock(&this->mMutex);
+    atomicStore(&this->mReady, Ready);
+    this->mDataReady.Broadcast();
+}
+
+int cLiveBuffer::available(uint64_t Position) const {
+    uint64_t Ready = this->ready();
+    if(!this->mPackets || !this->valid(Position)){
+        return -1;
+    }
+    return Position < Ready ? (int)(Ready - Position) : 0;
+}
+
+int cLiveBuffer::wait(uint64_t Position, int Count, int TimeoutMs){
+    cMutexLock MutexLock(&this->mMutex);
+    cTimeMs Start;
+    int Wakeups = this->mWakeups;
+    while(true){
+        int Available = this->available(Position);
+        int Remaining = TimeoutMs - (int)Start.Elapsed();
+        if(Available < 0 || Available >= Count || Wakeups != this->mWakeups || Remaining <= 0){
+            return Available;
+        }
+        this->mDataReady.TimedWait(this->mMutex, Remaining);
+    }
+}
+
+void cLiveBuffer::wakeup(){
+    cMutexLock MutexLock(&this->mMutex);
+    this->mWakeups++;
+    this->mDataReady.Broadcast();
+}
+
+uint64_t cLiveBuffer::gopStart() const {
+    uint64_t Ready = this->ready();
+    if(!this->mHasGop){
+        return Ready;
+    }
+    uint64_t Start = atomicLoad(&this->mGopStart);
+    // Keep a quarter of the buffer as room before the reader is overrun
+    if(Start >= Ready || this->head() - Start > (uint64_t)(this->mPackets / 4 * 3)){
+        return Ready;
+    }
+    return Start;
+}
+
+uint64_t cLiveBuffer::resync() const {
+    uint64_t Ready = this->ready();
+    uint64_t Behind = (uint64_t)(this->mPackets / 2);
+    return max(Ready > Behind ? Ready - Behind : 0, this->mFirst);
+}
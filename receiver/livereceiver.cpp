@@ -3,17 +3,28 @@
  * Author: savop
  * Author: J.Huber, IRT GmbH
  * Created on 4. Juni 2009, 13:28
- * Last modification: March 18, 2013
+ * Last modification: October 17, 2026
  */
 
+#include <limits.h>
 #include <vdr/thread.h>
 #include <vdr/remux.h>
 #include <vdr/device.h>
 #include <vdr/channels.h>
-#include <vdr/ringbuffer.h>
 #include "livereceiver.h"
+#include "config.h"
+
+cLiveReceiver* cLiveReceiver::newInstance(cChannel* Channel, int Priority, bool Spare){
+    if (Spare){
+        cDevice *Device = cDevice::GetDevice(Channel, IDLEPRIORITY, false);
+        // Never disturb the live view or other receivers for pretuning
+        if (!Device || Device == cDevice::ActualDevice() || Device->Receiving()){
+            MESSAGE(VERBOSE_LIVE_TV, "No spare device for channel \"%s\"", Channel->Name());
+            return NULL;
+        }
+        return new cLiveReceiver(Channel, Device, IDLEPRIORITY);
+    }
 
-cLiveReceiver* cLiveReceiver::newInstance(cChannel* Channel, int Priority){
     cDevice *Device = cDevice::GetDevice(Channel, Priority, true);
 
     if (!Device){
@@ -22,6 +33,8 @@ cLiveReceiver* cLiveReceiver::newInstance(cChannel* Channel, int Priority){
     }
     cLiveReceiver *Receiver = new cLiveReceiver(Channel, Device);
     if (Receiver){
+        // A failover must not take a device from anyone with a higher priority
+        Receiver->mPriority = Priority;
         MESSAGE(VERBOSE_SDK, "Receiver for channel \"%s\" created successfully.", Channel->Name());
         return Receiver;
     }
@@ -31,28 +44,96 @@ cLiveReceiver* cLiveReceiver::newInstance(cChannel* Channel, int Priority){
     }
 }
 
-cLiveReceiver::cLiveReceiver(cChannel *Channel, cDevice *Device) : cReceiver(Channel), 
+cLiveReceiver::cLiveReceiver(cChannel *Channel, cDevice *Device, int Priority) : cReceiver(Channel, Priority), 
 	              mDevice(Device), mChannel(Channel){
 //: cReceiver(Channel->GetChannelID(), 0, Channel->Vpid(), Channel->Apids(), Channel->Dpids(), Channel->Spids()), mDevice(Device), mChannel(Channel){
 	SetPids(Channel);
-    this->mLiveBuffer = NULL;
     this->mOutputBuffer = NULL;
+    this->mNextBuffer = NULL;
+    this->mAcquiring = 0;
     this->mFrameDetector = NULL;
+    this->mAnalyzed = 0;
+    this->mReceived = 0;
+    this->mOverflows = 0;
+    this->mPatPmtPackets = 0;
 	this->mVType = Channel->Vtype();
+    this->mClients = 0;
+    this->mIdleSince = 0;
+    this->mPretuned = false;
+    this->mTimeshift = NULL;
+    this->mReceivedBytes = 0;
+    this->mMeasuredBytes = 0;
+    this->mBitrate = 0;
+    this->mPeakFill = 0;
+    this->mMeasuredOverflows = 0;
+    this->mOverruns = 0;
+    this->mTimeshiftSynced = false;
+    this->mPatCounter = 0;
+    this->mPmtCounter = 0;
+    this->mPriority = Priority;
+    this->mLost = false;
+    this->mAttaching = false;
+    this->mFailingOver = false;
+    this->mFailoverAttempts = 0;
+    this->mFailovers = 0;
+    this->mOutageTime = 0;
+    this->mWatchedBytes = 0;
+    this->mRestamp = false;
 }
 
 cLiveReceiver::~cLiveReceiver(void){
     if(this->IsAttached())
         this->Detach();
+    if(this->mOverflows){
+        WARNING("Live receiver for channel \"%s\" fell behind %d times", this->mChannel->Name(), this->mOverflows);
+    }
+    if(this->mOutputBuffer){
+        MESSAGE(VERBOSE_LIVE_TV, "Live receiver for channel \"%s\": %d kbit/s, buffer of %d KB, peak fill %d%%, %d overflows, %d overrun readers",
+                this->mChannel->Name(), this->mBitrate, this->mOutputBuffer->packets() * TS_SIZE / 1024,
+                this->mPeakFill, this->mOverflows, this->mOverruns);
+    }
+    if(this->mFailovers){
+        MESSAGE(VERBOSE_LIVE_TV, "Live receiver for channel \"%s\" failed over %d times, %llu ms without data",
+                this->mChannel->Name(), this->mFailovers, (unsigned long long)this->mOutageTime);
+    }
+    for(int i = 0; i < this->mRetired.Size(); i++){
+        delete this->mRetired[i];
+    }
+    delete this->mNextBuffer; this->mNextBuffer = NULL;
+    delete this->mOutputBuffer; this->mOutputBuffer = NULL;
+    delete this->mFrameDetector; this->mFrameDetector = NULL;
+    delete this->mTimeshift; this->mTimeshift = NULL;
+    MESSAGE(VERBOSE_LIVE_TV, "Live receiver closed.");
 }
 
-void cLiveReceiver::open(UpnpOpenFileMode){
-    this->mLiveBuffer = new cRingBufferLinear(RECEIVER_LIVEBUFFER_SIZE, RECEIVER_RINGBUFFER_MARGIN, true, "Live TV buffer");
-    this->mOutputBuffer = new cRingBufferLinear(RECEIVER_OUTPUTBUFFER_SIZE, RECEIVER_RINGBUFFER_MARGIN, true, "Streaming buffer");
-
-    this->mLiveBuffer->SetTimeouts(0, 100);
-    this->mOutputBuffer->SetTimeouts(0, 500);
+bool cLiveReceiver::attach(){
+    this->mOutputBuffer = new cLiveBuffer(RECEIVER_LIVEBUFFER_SIZE);
+    int Timeshift = cUPnPConfig::get()->mLiveTimeshift;
+    if(Timeshift > 0 && !(this->mTimeshift = cTimeshiftFile::newInstance(this->mChannel, (off64_t)Timeshift * MB(1)))){
+        WARNING("Channel \"%s\" is received without timeshift", this->mChannel->Name());
+    }
     
+	if (!this->createFrameDetector()){
+		ERROR("Internal error with live receiver open");
+		return false;
+	}
+    // The PAT and PMT do not change, so they are generated only once
+    this->mPatPmtGenerator.SetChannel(this->mChannel);
+    memcpy(this->mPatPmt, this->mPatPmtGenerator.GetPat(), TS_SIZE);
+    this->mPatPmtPackets = 1;
+    int i = 0;
+    while(uchar* pmt = this->mPatPmtGenerator.GetPmt(i)){
+        if(this->mPatPmtPackets > MAX_PMT_TS) break;
+        memcpy(this->mPatPmt + this->mPatPmtPackets++ * TS_SIZE, pmt, TS_SIZE);
+    }
+    
+    this->mDevice->SwitchChannel(this->mChannel, false);
+    this->mStalled.Set();
+    return this->mDevice->AttachReceiver(this);
+}
+
+bool cLiveReceiver::createFrameDetector(){
+    delete this->mFrameDetector; this->mFrameDetector = NULL;
 	if (!ISRADIO(mChannel)){
 		this->mFrameDetector = new cFrameDetector(this->mChannel->Vpid(), this->mChannel->Vtype());
 	}
@@ -60,13 +141,84 @@ void cLiveReceiver::open(UpnpOpenFileMode){
 		MESSAGE(VERBOSE_LIVE_TV, " LiveReceiver opens with stream type 4; Vpid %i; Apid[0] %i", this->mChannel->Vpid(), this->mChannel->Apids()[0]);
 		this->mFrameDetector = new cFrameDetector(this->mChannel->Apids()[0], 4);
 	}
-	else {
-		ERROR("Internal error with live receiver open");
-	}
-    this->mPatPmtGenerator.SetChannel(this->mChannel);
-    
+    return this->mFrameDetector != NULL;
+}
+
+bool cLiveReceiver::isLost(){
+    return this->mLost || (!this->IsAttached() && !this->mAttaching && !this->isWatched());
+}
+
+bool cLiveReceiver::isWatched() const {
+    return !this->mLost && cUPnPConfig::get()->mLiveFailover > 0;
+}
+
+bool cLiveReceiver::failover(){
+    cDevice* Device = NULL;
+    for (int i = 0; i < cDevice::NumDevices() && !Device; i++){
+        cDevice* Candidate = cDevice::GetDevice(i);
+        bool NeedsDetachReceivers = false;
+        if (!Candidate || Candidate == this->mDevice) continue;
+        if (!Candidate->ProvidesChannel(this->mChannel, this->mPriority, &NeedsDetachReceivers) || NeedsDetachReceivers) continue;
+        // Never switch the live view to another transponder
+        if (Candidate == cDevice::ActualDevice() && !Candidate->IsTunedToTransponder(this->mChannel)) continue;
+        Device = Candidate;
+    }
+    if (!Device){
+        return false;
+    }
+    // Detaching stops the receiver thread, so nobody else touches the buffer
+    if (this->IsAttached()){
+        this->Detach();
+    }
+    // The packets of the new device continue the latest counter of each PID
+    memset(this->mNextCounter, RECEIVER_CC_UNKNOWN, sizeof(this->mNextCounter));
+    memset(this->mCounterShift, RECEIVER_CC_UNKNOWN, sizeof(this->mCounterShift));
+    for (uint64_t Sequence = this->mOutputBuffer->head(); Sequence > 0 && this->mOutputBuffer->valid(Sequence - 1); Sequence--){
+        const uchar* Packet = this->mOutputBuffer->packet(Sequence - 1);
+        int Pid = TsPid(Packet);
+        if (this->mNextCounter[Pid] == RECEIVER_CC_UNKNOWN){
+            this->mNextCounter[Pid] = (TsContinuityCounter(Packet) + (TsHasPayload(Packet) ? 1 : 0)) & TS_CONT_CNT_MASK;
+        }
+    }
+    this->mRestamp = true;
+    // The new device starts somewhere within a frame
+    this->createFrameDetector();
+    this->mTimeshiftSynced = false;
+
+    cDevice* Previous = this->mDevice;
+    this->mDevice = Device;
     this->mDevice->SwitchChannel(this->mChannel, false);
-    this->mDevice->AttachReceiver(this);
+    if (!this->mDevice->AttachReceiver(this)){
+        ERROR("Failed to attach the receiver for channel \"%s\" to device %d", this->mChannel->Name(), Device->CardIndex() + 1);
+        return false;
+    }
+    WARNING("Live receiver for channel \"%s\" failed over from device %d to device %d", this->mChannel->Name(),
+            Previous->CardIndex() + 1, Device->CardIndex() + 1);
+    return true;
+}
+
+void cLiveReceiver::giveUp(){
+    this->mLost = true;
+    // Both wake up the streams, so they end
+    if (this->IsAttached()){
+        this->Detach();
+    }
+    else {
+        this->Activate(false);
+    }
+}
+
+void cLiveReceiver::restamp(uchar* Packet){
+    int Pid = TsPid(Packet);
+    int Counter = TsContinuityCounter(Packet);
+    uchar &Shift = this->mCounterShift[Pid];
+    if (Shift == RECEIVER_CC_UNKNOWN){
+        int Next = this->mNextCounter[Pid];
+        // Packets without payload repeat the counter of the previous packet
+        int Expected = TsHasPayload(Packet) ? Next : Next - 1;
+        Shift = (Next == RECEIVER_CC_UNKNOWN) ? 0 : (uchar)((Expected - Counter) & TS_CONT_CNT_MASK);
+    }
+    TsSetContinuityCounter(Packet, Counter + Shift);
 }
 
 void cLiveReceiver::Activate(bool On){
@@ -78,140 +230,547 @@ void cLiveReceiver::Activate(bool On){
         if(this->Running()){
             this->Cancel(2);
         }
+        // Do not let the clients wait for data which will never come
+        if(this->mOutputBuffer){
+            cLiveBufferRef Buffer(this);
+            Buffer->wakeup();
+        }
+        if(this->mTimeshift){
+            this->mTimeshift->wakeup();
+        }
         MESSAGE(VERBOSE_LIVE_TV, "Live receiver stopped");
     }
 }
 
 void cLiveReceiver::Receive(uchar* Data, int Length){
     if (this->Running()){
-        int bytesWrote = this->mLiveBuffer->Put(Data, Length);
-        if (bytesWrote != Length && this->Running()){
-            this->mLiveBuffer->ReportOverflow(Length - bytesWrote);
+        // Take over a resized buffer, the receiver thread waits meanwhile
+        cLiveBuffer* Next = this->mNextBuffer;
+        if (Next && __sync_bool_compare_and_swap(&this->mNextBuffer, Next, (cLiveBuffer*)NULL)){
+            cLiveBuffer* Previous = this->mOutputBuffer;
+            Next->adopt(Previous);
+            __sync_bool_compare_and_swap(&this->mOutputBuffer, Previous, Next);
+        }
+        __sync_add_and_fetch(&this->mReceivedBytes, (uint64_t)Length);
+        for (; Length >= TS_SIZE; Data += TS_SIZE, Length -= TS_SIZE){
+            if (this->mRestamp){
+                uchar Packet[TS_SIZE];
+                memcpy(Packet, Data, TS_SIZE);
+                this->restamp(Packet);
+                this->mOutputBuffer->put(Packet);
+            }
+            else {
+                this->mOutputBuffer->put(Data);
+            }
+        }
+        if (++this->mReceived % RECEIVER_SIGNAL_PACKETS == 0){
+            this->mNewData.Signal();
         }
     }
 }
 
 void cLiveReceiver::Action(void){
     MESSAGE(VERBOSE_LIVE_TV, "Started buffering...");
-	bool isRadio = ISRADIO (this->mChannel);
 	const int debugRepeat = 32;
 	long debugCtr = 0;
-	int accBytesWrote = 0;
+    this->mAnalyzed = this->mOutputBuffer->head();
+    this->mMeasureTime.Set();
     while(this->Running()){
-        int bytesRead;
-		if ((debugCtr % debugRepeat) == 0){
-			MESSAGE(VERBOSE_BUFFERS, "Buffer is filled with %d bytes", this->mLiveBuffer->Available());
+        this->measure();
+        int Packets = this->mOutputBuffer->packets();
+        uint64_t Head = this->mOutputBuffer->head();
+        // Packets are overwritten before they were analyzed, so skip them
+        if (Head - this->mAnalyzed > (uint64_t)Packets - RECEIVER_ANALYZE_PACKETS){
+            this->mOverflows++;
+            WARNING("Live receiver fell behind, skipping %d packets", (int)(Head - this->mAnalyzed - Packets / 2));
+            this->mAnalyzed = Head - Packets / 2;
+        }
+        int Pending = (int)(Head - this->mAnalyzed);
+        this->mPeakFill = max(this->mPeakFill, Pending * 100 / Packets);
+        if ((debugCtr % debugRepeat) == 0){
+			MESSAGE(VERBOSE_BUFFERS, "Buffer is filled with %d packets not yet analyzed", Pending);
 		}
-        uchar* bytes = this->mLiveBuffer->Get(bytesRead);
-//		MESSAGE(VERBOSE_BUFFERS, "Number of bytes read: %i", bytesRead);
-        if (bytes){
-            int count = this->mFrameDetector->Analyze(bytes, bytesRead);
-            if (count){
-				double framesPerSec = this->mFrameDetector->FramesPerSecond();
-				if ((this->mFrameDetector->Synced() && (debugCtr % debugRepeat) == 0) || (!this->mFrameDetector->Synced() && (debugCtr % 200) == 0)) {
-					 MESSAGE(VERBOSE_BUFFERS, "%d bytes analyzed; %2.2f FPS", count, framesPerSec);
-				}
-                if (!this->Running() && this->mFrameDetector->IndependentFrame())
-                    break;
-                if (this->mFrameDetector->Synced() || (!this->mFrameDetector->Synced() && ((int)this->mLiveBuffer->Available() > 120000 || 
-					   (isRadio && (int)this->mLiveBuffer->Available() > 10000)))){
-                    if(this->mFrameDetector->IndependentFrame()){
-                        this->mOutputBuffer->Put(this->mPatPmtGenerator.GetPat(), TS_SIZE);
-                        int i = 0;
-                        while(uchar* pmt = this->mPatPmtGenerator.GetPmt(i)){
-                            this->mOutputBuffer->Put(pmt, TS_SIZE);
-                        }
-                    }
-                    int bytesWrote = this->mOutputBuffer->Put(bytes, count);
-                    if (bytesWrote != count){
-                        this->mLiveBuffer->ReportOverflow(count - bytesWrote);
-                    }
-					if ((debugCtr % 4) == 0){
-						MESSAGE(VERBOSE_BUFFERS, "Wrote %d to output buffer", accBytesWrote);
-						accBytesWrote = 0;
-					}
-					else {
-						accBytesWrote += bytesWrote;
-					}
-                    if(bytesWrote){
-                        this->mLiveBuffer->Del(bytesWrote);
-                    }
-                    else {
-                        cCondWait::SleepMs(100);
-                    }
-                }
-                else {
-					if ((debugCtr % 200) == 0){
-	                   WARNING("Cannot sync to stream, VType: %i, debug counter: %ld", this->mVType, debugCtr);
-					}
-                }
+		debugCtr++;
+        if (Pending < RECEIVER_ANALYZE_PACKETS){
+            this->mNewData.Wait(RECEIVER_ANALYZE_WAIT);
+            continue;
+        }
+        uchar* bytes = this->mOutputBuffer->packet(this->mAnalyzed);
+        int Contiguous = min(Pending, Packets - (int)(this->mAnalyzed % Packets));
+        if (Contiguous < RECEIVER_ANALYZE_PACKETS){
+            // The packets wrap around the end of the buffer
+            for (int i = 0; i < RECEIVER_ANALYZE_PACKETS; i++){
+                memcpy(this->mScratch + i * TS_SIZE, this->mOutputBuffer->packet(this->mAnalyzed + i), TS_SIZE);
             }
+            bytes = this->mScratch;
+            Contiguous = RECEIVER_ANALYZE_PACKETS;
+        }
+        int count = this->mFrameDetector->Analyze(bytes, Contiguous * TS_SIZE);
+        if (count){
+            if ((this->mFrameDetector->Synced() && (debugCtr % debugRepeat) == 0) || (!this->mFrameDetector->Synced() && (debugCtr % 200) == 0)) {
+                MESSAGE(VERBOSE_BUFFERS, "%d bytes analyzed; %2.2f FPS", count, this->mFrameDetector->FramesPerSecond());
+            }
+            bool Independent = this->mFrameDetector->Synced() && this->mFrameDetector->NewFrame() && this->mFrameDetector->IndependentFrame();
+            if (Independent){
+                this->mOutputBuffer->markIndependentFrame(this->mAnalyzed);
+            }
+            if (this->mTimeshift){
+                this->writeTimeshift(Independent, (count + TS_SIZE - 1) / TS_SIZE);
+            }
+            this->mAnalyzed += (count + TS_SIZE - 1) / TS_SIZE;
+            this->mOutputBuffer->publish(this->mAnalyzed);
+        }
+        else {
+            this->mNewData.Wait(RECEIVER_ANALYZE_WAIT);
         }
-		debugCtr++;
     }
     MESSAGE(VERBOSE_LIVE_TV, "Receiver was detached from device");
 }
 
-int cLiveReceiver::read(char* buf, size_t buflen){
-    int bytesRead = 0;
-    if(!this->IsAttached())
-        bytesRead = -1;
-    else {
-        int WaitTimeout = RECEIVER_WAIT_ON_NODATA_TIMEOUT;
-        // Wait until the buffer size is at least half the requested buffer length
-		int min_buffer_fillage = (this->mVType == 0) ? 6 : (RECEIVER_MIN_BUFFER_FILLAGE * 10); // as percentage*10 of buflen
-//		int min_buffer_fillage = (this->mVType == 0) ? 11 : (RECEIVER_MIN_BUFFER_FILLAGE * 10); // as percentage*10 of buflen
-        double MinBufSize = buflen * min_buffer_fillage/1000;
-        int Available = 0;
-        while ((double)(Available = this->mOutputBuffer->Available()) < MinBufSize){
- //           WARNING("Too few data, waiting...");
-            WARNING("Waiting... Only %d bytes available, need %ld more bytes.", Available, (long)(MinBufSize-Available));
-            cCondWait::SleepMs(RECEIVER_WAIT_ON_NODATA);
-            if (!this->IsAttached()){
-                MESSAGE(VERBOSE_LIVE_TV, "Lost device...");
-                return 0;
-            }
-            WaitTimeout-=RECEIVER_WAIT_ON_NODATA;
-            if (WaitTimeout <= 0){
-                double seconds = (RECEIVER_WAIT_ON_NODATA_TIMEOUT/1000);
-                ERROR("No data received for %4.2f seconds, aborting.", seconds);
-                this->Activate(false);
-                return 0;
+void cLiveReceiver::writeTimeshift(bool Independent, int Packets){
+    if (Independent){
+        this->mTimeshift->markIndependentFrame();
+        for (int i = 0; i < this->mPatPmtPackets; i++){
+            uchar Packet[TS_SIZE];
+            memcpy(Packet, this->mPatPmt + i * TS_SIZE, TS_SIZE);
+            uchar Counter = (i == 0) ? this->mPatCounter++ : this->mPmtCounter++;
+            Packet[3] = (Packet[3] & ~TS_CONT_CNT_MASK) | (Counter & TS_CONT_CNT_MASK);
+            this->mTimeshift->write(Packet, TS_SIZE);
+        }
+        this->mTimeshiftSynced = true;
+    }
+    if (!this->mTimeshiftSynced){
+        return;
+    }
+    int BufferPackets = this->mOutputBuffer->packets();
+    for (uint64_t Sequence = this->mAnalyzed; Packets > 0; ){
+        // The packets may wrap around the end of the buffer
+        int Contiguous = min(Packets, BufferPackets - (int)(Sequence % BufferPackets));
+        this->mTimeshift->write(this->mOutputBuffer->packet(Sequence), Contiguous * TS_SIZE);
+        Sequence += Contiguous;
+        Packets -= Contiguous;
+    }
+    this->mTimeshift->publish();
+}
+
+cLiveBuffer* cLiveReceiver::acquireBuffer(){
+    // A buffer loaded meanwhile may already be retired, so it must not be deleted yet
+    __sync_add_and_fetch(&this->mAcquiring, 1);
+    cLiveBuffer* Buffer = this->mOutputBuffer;
+    Buffer->addReader(1);
+    __sync_sub_and_fetch(&this->mAcquiring, 1);
+    return Buffer;
+}
+
+void cLiveReceiver::releaseBuffer(cLiveBuffer* Buffer){
+    Buffer->addReader(-1);
+}
+
+void cLiveReceiver::countOverrun(){
+    __sync_add_and_fetch(&this->mOverruns, 1);
+}
+
+int cLiveReceiver::getFill(){
+    cLiveBufferRef Buffer(this);
+    int Packets = Buffer->packets();
+    return Packets ? (int)min((Buffer->head() - this->mAnalyzed) * 100 / Packets, (uint64_t)100) : 0;
+}
+
+int cLiveReceiver::getBufferSize(){
+    cLiveBufferRef Buffer(this);
+    return Buffer->packets() * TS_SIZE;
+}
+
+void cLiveReceiver::measure(){
+    // Readers acquire the current buffer, so a retired one is free once it has no readers
+    if(this->mRetired.Size() && !__sync_add_and_fetch(&this->mAcquiring, 0)){
+        for(int i = this->mRetired.Size() - 1; i >= 0; i--){
+            if(!this->mRetired[i]->readers()){
+                delete this->mRetired[i];
+                this->mRetired.Remove(i);
             }
         }
+    }
+    uint64_t Elapsed = this->mMeasureTime.Elapsed();
+    bool Overflow = this->mOverflows != this->mMeasuredOverflows;
+    if(!Elapsed || (Elapsed < RECEIVER_RESIZE_INTERVAL && !Overflow)){
+        return;
+    }
+    uint64_t Received = __sync_add_and_fetch(&this->mReceivedBytes, 0);
+    uint64_t Bytes = Received - this->mMeasuredBytes;
+    this->mMeasuredBytes = Received;
+    this->mMeasureTime.Set();
+    this->mMeasuredOverflows = this->mOverflows;
+    // Bytes per millisecond times 8 is kbit/s
+    this->mBitrate = (int)(Bytes * 8 / Elapsed);
 
-        uchar* buffer = this->mOutputBuffer->Get(bytesRead);
-        if (buffer){
-            if (buflen > (size_t)bytesRead){
-                memcpy(buf,(char*)buffer,bytesRead);
-                this->mOutputBuffer->Del(bytesRead);
+    cUPnPConfig* Config = cUPnPConfig::get();
+    int Current = this->mOutputBuffer->packets() * TS_SIZE;
+    int Size = (int)min(Bytes * 1000 / Elapsed * RECEIVER_LIVEBUFFER_SECONDS, (uint64_t)INT_MAX);
+    if(Overflow){
+        Size = max(Size, Current * 2);
+    }
+    Size = max(min(Size, Config->mLiveBufferMax * KB(1)), Config->mLiveBufferMin * KB(1));
+    // Never drop packets, which are not analyzed yet
+    int Pending = (int)(this->mOutputBuffer->head() - this->mAnalyzed);
+    Size = max(Size, (Pending + RECEIVER_ANALYZE_PACKETS) * TS_SIZE * 2);
+    // Avoid resizing back and forth on small changes of the bitrate
+    if(Size > Current || Size < Current / 2){
+        this->resize(Size);
+    }
+}
+
+void cLiveReceiver::resize(int Size){
+    cLiveBuffer* Buffer = new cLiveBuffer(Size);
+    if(!Buffer->packets()){
+        delete Buffer;
+        return;
+    }
+    cLiveBuffer* Previous = this->mOutputBuffer;
+    __sync_bool_compare_and_swap(&this->mNextBuffer, (cLiveBuffer*)NULL, Buffer);
+    cTimeMs Timeout(RECEIVER_SWAP_TIMEOUT);
+    while(this->mOutputBuffer != Buffer){
+        // The writer may have taken the buffer just now, then it swaps it at once
+        if((Timeout.TimedOut() || !this->Running()) && __sync_bool_compare_and_swap(&this->mNextBuffer, Buffer, (cLiveBuffer*)NULL)){
+            MESSAGE(VERBOSE_LIVE_TV, "Live buffer for channel \"%s\" not resized, no data arrived", this->mChannel->Name());
+            delete Buffer;
+            return;
+        }
+        cCondWait::SleepMs(1);
+    }
+    this->mRetired.Append(Previous);
+    // Readers waiting for the old buffer continue with the new one
+    Previous->wakeup();
+    MESSAGE(VERBOSE_LIVE_TV, "Live buffer for channel \"%s\" resized from %d KB to %d KB at %d kbit/s",
+            this->mChannel->Name(), Previous->packets() * TS_SIZE / 1024, Buffer->packets() * TS_SIZE / 1024, this->mBitrate);
+}
+
+cLiveReceivers* cLiveReceivers::mInstance = NULL;
+
+cLiveReceivers::cLiveReceivers() : cThread("UPnP live receiver pool"){
+    this->mPretuneNumber = 0;
+    this->mHits = 0;
+    this->mMisses = 0;
+    this->mPretunes = 0;
+    this->mFailovers = 0;
+    this->mFailedFailovers = 0;
+}
+
+cLiveReceivers* cLiveReceivers::getInstance(){
+    if(cLiveReceivers::mInstance == NULL)
+        cLiveReceivers::mInstance = new cLiveReceivers();
+
+    return cLiveReceivers::mInstance;
+}
+
+cLiveReceiver* cLiveReceivers::find(const tChannelID &ChannelID){
+    for(int i = 0; i < this->mReceivers.Size(); i++){
+        cLiveReceiver* Receiver = this->mReceivers[i];
+        // A receiver which lost its device is left to its current clients
+        if(Receiver->mChannel->GetChannelID() == ChannelID && !Receiver->isLost()){
+            return Receiver;
+        }
+    }
+    return NULL;
+}
+
+cLiveReceiver* cLiveReceivers::getReceiver(cChannel* Channel, int Priority){
+    cUPnPConfig* Config = cUPnPConfig::get();
+    this->mMutex.Lock();
+    if((Config->mLivePoolTime > 0 || Config->mLiveFailover > 0) && !this->Running()){
+        this->Start();
+    }
+    if(Config->mLivePoolTime > 0 && Config->mLivePretune > 0){
+        this->mPretuneNumber = Channel->Number();
+        this->mWakeup.Signal();
+    }
+
+    cLiveReceiver* Receiver = this->find(Channel->GetChannelID());
+    if(Receiver){
+        if(Receiver->mClients++ == 0){
+            // The watchdog did not watch the receiver while it was idle
+            Receiver->mStalled.Set();
+            this->mHits++;
+            MESSAGE(VERBOSE_LIVE_TV, "Using the %s receiver for channel \"%s\" from the pool (%ld hits, %ld misses)",
+                    Receiver->mPretuned ? "pretuned" : "idle", Channel->Name(), this->mHits, this->mMisses);
+        }
+        else {
+            MESSAGE(VERBOSE_LIVE_TV, "Sharing the receiver for channel \"%s\" with %d clients", Channel->Name(), Receiver->mClients);
+        }
+        this->mMutex.Unlock();
+        return Receiver;
+    }
+
+    Receiver = cLiveReceiver::newInstance(Channel, Priority);
+    if(!Receiver){
+        this->mMutex.Unlock();
+        return NULL;
+    }
+    if(Config->mLivePoolTime > 0){
+        this->mMisses++;
+    }
+    // Clients of the same channel share the receiver while it attaches
+    Receiver->mClients = 1;
+    Receiver->mAttaching = true;
+    this->mReceivers.Append(Receiver);
+    this->mMutex.Unlock();
+
+    // Switching the channel and attaching may take a while
+    bool Attached = Receiver->attach();
+    this->mMutex.Lock();
+    Receiver->mAttaching = false;
+    this->mMutex.Unlock();
+    if(!Attached){
+        ERROR("Failed to attach the receiver for channel \"%s\"", Channel->Name());
+        // The clients which joined meanwhile end their streams
+        Receiver->giveUp();
+        this->releaseReceiver(Receiver);
+        return NULL;
+    }
+    return Receiver;
+}
+
+void cLiveReceivers::releaseReceiver(cLiveReceiver* Receiver){
+    if(!Receiver) return;
+
+    this->mMutex.Lock();
+    if(--Receiver->mClients > 0){
+        MESSAGE(VERBOSE_LIVE_TV, "Receiver for channel \"%s\" still has %d clients", Receiver->mChannel->Name(), Receiver->mClients);
+        this->mMutex.Unlock();
+        return;
+    }
+    if(Receiver->mAttaching){
+        // The pool thread is still pretuning it and deletes it, if that fails
+        Receiver->mIdleSince = cTimeMs::Now();
+        this->mMutex.Unlock();
+        return;
+    }
+    if(cUPnPConfig::get()->mLivePoolTime > 0 && Receiver->IsAttached() && this->Running()){
+        // The pool thread deletes the receiver when it expires
+        Receiver->mIdleSince = cTimeMs::Now();
+        Receiver->mPretuned = false;
+        MESSAGE(VERBOSE_LIVE_TV, "Keeping the receiver for channel \"%s\" in the pool", Receiver->mChannel->Name());
+        this->mMutex.Unlock();
+        return;
+    }
+    for(int i = 0; i < this->mReceivers.Size(); i++){
+        if(this->mReceivers[i] == Receiver){
+            this->mReceivers.Remove(i);
+            break;
+        }
+    }
+    this->mMutex.Unlock();
+    // Detaching stops the receiver thread, which may take a while
+    MESSAGE(VERBOSE_SDK, "Closing live receiver");
+    delete Receiver;
+}
+
+int cLiveReceivers::count(){
+    cMutexLock MutexLock(&this->mMutex);
+    return this->mReceivers.Size();
+}
+
+int cLiveReceivers::idle(){
+    cMutexLock MutexLock(&this->mMutex);
+    int Idle = 0;
+    for(int i = 0; i < this->mReceivers.Size(); i++){
+        if(this->mReceivers[i]->mClients == 0) Idle++;
+    }
+    return Idle;
+}
+
+void cLiveReceivers::getStatus(std::vector<cLiveReceiverStatus> &Status){
+    cMutexLock MutexLock(&this->mMutex);
+    Status.clear();
+    for(int i = 0; i < this->mReceivers.Size(); i++){
+        cLiveReceiver* Receiver = this->mReceivers[i];
+        cLiveReceiverStatus Current;
+        Current.ChannelID = Receiver->mChannel->GetChannelID();
+        Current.Clients = Receiver->mClients;
+        Current.Bitrate = Receiver->mBitrate;
+        Current.BufferSize = Receiver->getBufferSize();
+        Current.Fill = Receiver->getFill();
+        Current.PeakFill = Receiver->mPeakFill;
+        Current.Overflows = Receiver->mOverflows;
+        Current.Overruns = Receiver->mOverruns;
+        Status.push_back(Current);
+    }
+}
+
+bool cLiveReceivers::getTimeshiftWindow(const tChannelID &ChannelID, uint64_t &Start, uint64_t &Length){
+    cMutexLock MutexLock(&this->mMutex);
+    cLiveReceiver* Receiver = this->find(ChannelID);
+    if(!Receiver || !Receiver->mTimeshift){
+        return false;
+    }
+    Start = Receiver->mTimeshift->start();
+    Length = Receiver->mTimeshift->length();
+    return true;
+}
+
+void cLiveReceivers::pretune(int Number){
+    int Range = cUPnPConfig::get()->mLivePretune;
+    for(int Distance = 1; Distance <= Range && this->Running(); Distance++){
+        for(int Direction = 1; Direction >= -1; Direction -= 2){
+            cChannel* Channel = Channels.GetByNumber(Number + Direction * Distance);
+            if(!Channel || Channel->GroupSep()) continue;
+
+            this->mMutex.Lock();
+            if(this->find(Channel->GetChannelID())){
+                this->mMutex.Unlock();
+                continue;
             }
-            else {
-                memcpy(buf,(char*)buffer,buflen);
-                this->mOutputBuffer->Del(buflen);
+            cLiveReceiver* Receiver = cLiveReceiver::newInstance(Channel, IDLEPRIORITY, true);
+            if(!Receiver){
+                // All spare devices are in use
+                this->mMutex.Unlock();
+                return;
             }
+            // Clients may take over the receiver while it attaches
+            Receiver->mClients = 0;
+            Receiver->mIdleSince = cTimeMs::Now();
+            Receiver->mPretuned = true;
+            Receiver->mAttaching = true;
+            this->mReceivers.Append(Receiver);
+            this->mMutex.Unlock();
+
+            // Switching the channel and attaching may take a while
+            bool Attached = Receiver->attach();
+            this->mMutex.Lock();
+            Receiver->mAttaching = false;
+            if(Attached){
+                this->mPretunes++;
+                this->mMutex.Unlock();
+                MESSAGE(VERBOSE_LIVE_TV, "Pretuned channel \"%s\"", Channel->Name());
+                continue;
+            }
+            ERROR("Failed to attach the pretuned receiver for channel \"%s\"", Channel->Name());
+            if(Receiver->mClients > 0){
+                this->mMutex.Unlock();
+                // The clients which took it over end their streams and release it
+                Receiver->giveUp();
+                continue;
+            }
+            for(int i = 0; i < this->mReceivers.Size(); i++){
+                if(this->mReceivers[i] == Receiver){
+                    this->mReceivers.Remove(i);
+                    break;
+                }
+            }
+            this->mMutex.Unlock();
+            delete Receiver;
         }
+    }
+}
+
+int cLiveReceivers::expire(){
+    cVector<cLiveReceiver*> Expired;
+    uint64_t Now = cTimeMs::Now();
+    uint64_t PoolTime = (uint64_t)cUPnPConfig::get()->mLivePoolTime * 1000;
 
+    this->mMutex.Lock();
+    for(int i = this->mReceivers.Size() - 1; i >= 0; i--){
+        cLiveReceiver* Receiver = this->mReceivers[i];
+        if(Receiver->mClients == 0 && (!Receiver->IsAttached() || !this->Running() || Now - Receiver->mIdleSince >= PoolTime)){
+            this->mReceivers.Remove(i);
+            Expired.Append(Receiver);
+        }
+    }
+    this->mMutex.Unlock();
+    // Detaching stops the receiver threads, which may take a while
+    for(int i = 0; i < Expired.Size(); i++){
+        MESSAGE(VERBOSE_LIVE_TV, "Receiver for channel \"%s\" expired in the pool", Expired[i]->mChannel->Name());
+        delete Expired[i];
     }
-    MESSAGE(VERBOSE_BUFFERS, "Read %d bytes from live feed", bytesRead);
-    return bytesRead;
+    return Expired.Size();
 }
 
-int cLiveReceiver::seek(off_t, int){
-    ERROR("Seeking not supported on broadcasts");
-    return 0;
+void cLiveReceivers::watch(){
+    int Timeout = cUPnPConfig::get()->mLiveFailover;
+    if(Timeout <= 0) return;
+
+    cVector<cLiveReceiver*> Stalled;
+    this->mMutex.Lock();
+    for(int i = 0; i < this->mReceivers.Size(); i++){
+        cLiveReceiver* Receiver = this->mReceivers[i];
+        if(Receiver->mClients == 0 || Receiver->mLost || Receiver->mAttaching) continue;
+
+        uint64_t Bytes = __sync_add_and_fetch(&Receiver->mReceivedBytes, 0);
+        if(Bytes != Receiver->mWatchedBytes){
+            Receiver->mWatchedBytes = Bytes;
+            if(Receiver->mFailingOver){
+                uint64_t Outage = Receiver->mStalled.Elapsed();
+                Receiver->mOutageTime += Outage;
+                Receiver->mFailovers++;
+                Receiver->mFailingOver = false;
+                Receiver->mFailoverAttempts = 0;
+                this->mFailovers++;
+                MESSAGE(VERBOSE_LIVE_TV, "Receiver for channel \"%s\" is back after %llu ms without data",
+                        Receiver->mChannel->Name(), (unsigned long long)Outage);
+            }
+            Receiver->mStalled.Set();
+            continue;
+        }
+        // Give the device of the last attempt the time to tune
+        uint64_t Elapsed = Receiver->mFailingOver ? Receiver->mAttempt.Elapsed() : Receiver->mStalled.Elapsed();
+        if(Receiver->IsAttached() && Elapsed < (uint64_t)Timeout) continue;
+
+        // The reference keeps the receiver, while it fails over without the lock
+        Receiver->mClients++;
+        Stalled.Append(Receiver);
+    }
+    this->mMutex.Unlock();
+
+    // Detaching stops the receiver thread and tuning may take a while
+    for(int i = 0; i < Stalled.Size(); i++){
+        cLiveReceiver* Receiver = Stalled[i];
+        WARNING("Receiver for channel \"%s\" %s", Receiver->mChannel->Name(),
+                Receiver->IsAttached() ? "delivers no data" : "lost its device");
+        if(Receiver->mFailoverAttempts < RECEIVER_FAILOVER_ATTEMPTS && Receiver->failover()){
+            Receiver->mFailingOver = true;
+            Receiver->mFailoverAttempts++;
+            Receiver->mAttempt.Set();
+        }
+        else {
+            ERROR("No other device delivers channel \"%s\", giving up", Receiver->mChannel->Name());
+            Receiver->giveUp();
+            this->mFailedFailovers++;
+        }
+        this->releaseReceiver(Receiver);
+    }
 }
 
-int cLiveReceiver::write(char*, size_t){
-    ERROR("Writing not allowed on broadcasts");
-    return 0;
+void cLiveReceivers::Action(void){
+    MESSAGE(VERBOSE_LIVE_TV, "Live receiver pool started");
+    while(this->Running()){
+        this->mWakeup.Wait(cUPnPConfig::get()->mLiveFailover > 0 ? RECEIVER_WATCHDOG_INTERVAL : RECEIVER_POOL_INTERVAL);
+        this->watch();
+        int Number = 0;
+        this->mMutex.Lock();
+        Number = this->mPretuneNumber;
+        this->mPretuneNumber = 0;
+        this->mMutex.Unlock();
+        if(Number){
+            this->pretune(Number);
+        }
+        if(this->expire() || Number){
+            MESSAGE(VERBOSE_LIVE_TV, "Live receiver pool: %d of %d receivers idle, %ld hits, %ld misses, %ld pretuned",
+                    this->idle(), this->count(), this->mHits, this->mMisses, this->mPretunes);
+        }
+    }
 }
 
-void cLiveReceiver::close(){
-    MESSAGE(VERBOSE_SDK, "Closing live receiver");
-    this->Detach();
-    delete this->mOutputBuffer; this->mOutputBuffer = NULL;
-    delete this->mLiveBuffer; this->mLiveBuffer = NULL;
-    this->mFrameDetector = NULL;
-    MESSAGE(VERBOSE_LIVE_TV, "Live receiver closed.");
-}
\ No newline at end of file
+void cLiveReceivers::clear(){
+    if(this->Running()){
+        this->Cancel(-1);
+        this->mWakeup.Signal();
+        this->Cancel(3);
+    }
+    this->expire();
+    if(this->mHits || this->mMisses){
+        MESSAGE(VERBOSE_LIVE_TV, "Live receiver pool served %ld of %ld clients", this->mHits, this->mHits + this->mMisses);
+    }
+    if(this->mFailovers || this->mFailedFailovers){
+        MESSAGE(VERBOSE_LIVE_TV, "Live receiver watchdog: %ld failovers, %ld receivers given up", this->mFailovers, this->mFailedFailovers);
+    }
+}
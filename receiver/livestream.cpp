@@ -0,0 +1,442 @@
+/*
+ * File:   livestream.cpp
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#include <vdr/thread.h>
+#include <vdr/channels.h>
+#include "livestream.h"
+#include "config.h"
+
+cLiveStream* cLiveStream::newInstance(cChannel* Channel, int Priority){
+    cLiveReceiver* Receiver = cLiveReceivers::getInstance()->getReceiver(Channel, Priority);
+    if(!Receiver){
+        ERROR("No receiver available for channel \"%s\"", Channel->Name());
+        return NULL;
+    }
+    return new cLiveStream(Receiver);
+}
+
+cLiveStream::cLiveStream(cLiveReceiver* Receiver) : mReceiver(Receiver){
+    this->mTimeshift = Receiver->getTimeshift();
+    this->mOffset = 0;
+    this->mPosition = 0;
+    this->mSyncStart = 0;
+    this->mSynced = false;
+    this->mPatCounter = 0;
+    this->mPmtCounter = 0;
+    this->mPidFilter = NULL;
+    const uchar* PatPmt = Receiver->getPatPmt(this->mPatPmtPackets);
+    memcpy(this->mPatPmt, PatPmt, this->mPatPmtPackets * TS_SIZE);
+    this->mPmtPid = (this->mPatPmtPackets > 1) ? TsPid(this->mPatPmt + TS_SIZE) : -1;
+    this->mPmtIndex = 0;
+    this->mAudioPid = 0;
+    this->mAudioSynced = false;
+    cChannel* Channel = Receiver->getChannel();
+    if(ISRADIO(Channel) && !cUPnPConfig::get()->mRadioTS && Channel->Apid(0)){
+        switch(Channel->Atype(0)){
+            case 0x03: // MPEG-1 audio
+            case 0x04: // MPEG-2 audio
+            case 0x0F: // AAC with ADTS
+                this->mAudioPid = Channel->Apid(0);
+                break;
+            default:
+                MESSAGE(VERBOSE_LIVE_TV, "Streaming audio type %d of channel \"%s\" as transport stream", Channel->Atype(0), Channel->Name());
+                break;
+        }
+    }
+    this->mVType = Receiver->getChannel()->Vtype();
+    this->mDroppedBytes = 0;
+    this->mOverruns = 0;
+    this->mOpenTime = cTimeMs::Now();
+    this->mTimeToFirstByte = -1;
+    this->mWaitTime = 0;
+    this->mWaits = 0;
+}
+
+cLiveStream::~cLiveStream(){
+    this->close();
+    delete this->mPidFilter;
+}
+
+bool cLiveStream::selectAudio(const char* Selection){
+    cPidFilter* Filter = cPidFilter::newInstance(this->mReceiver->getChannel(), Selection);
+    if(!Filter){
+        WARNING("No audio track selected with '%s', streaming all tracks", Selection);
+        return false;
+    }
+    int PatPmtPackets = 0;
+    const uchar* PatPmt = this->mReceiver->getPatPmt(PatPmtPackets);
+    int PmtPackets = Filter->rewritePmt(PatPmt + TS_SIZE, PatPmtPackets - 1, this->mPatPmt + TS_SIZE);
+    if(!PmtPackets){
+        ERROR("Failed to rewrite the PMT, streaming all tracks");
+        memcpy(this->mPatPmt, PatPmt, PatPmtPackets * TS_SIZE);
+        delete Filter;
+        return false;
+    }
+    this->mPatPmtPackets = 1 + PmtPackets;
+    delete this->mPidFilter;
+    this->mPidFilter = Filter;
+    return true;
+}
+
+void cLiveStream::open(UpnpOpenFileMode){
+    // New clients start with the latest group of pictures, which is still in
+    // the buffer, so they do not have to wait for the next independent frame
+    cLiveBufferRef Buffer(this->mReceiver);
+    uint64_t Ready = Buffer->ready();
+    this->mPosition = Buffer->gopStart();
+    this->mSyncStart = this->mPosition;
+    this->mSynced = false;
+    if(this->mTimeshift){
+        this->mOffset = this->mTimeshift->gopStart();
+    }
+    else if(this->mPosition < Ready){
+        MESSAGE(VERBOSE_LIVE_TV, "Live stream starts with %d cached packets", (int)(Ready - this->mPosition));
+    }
+    this->mOpenTime = cTimeMs::Now();
+    MESSAGE(VERBOSE_LIVE_TV, "Live stream opened for channel \"%s\"", this->mReceiver->getChannel()->Name());
+}
+
+bool cLiveStream::handleOverrun(){
+    this->mOverruns++;
+    this->mReceiver->countOverrun();
+    if(cUPnPConfig::get()->mLiveSlowReader == RECEIVER_SLOW_READER_DISCONNECT){
+        ERROR("Live stream client is too slow, disconnecting");
+        return false;
+    }
+    // The audio continues with the next complete PES packet
+    this->mAudioSynced = false;
+    if(this->mTimeshift){
+        uint64_t Offset = this->mTimeshift->resync();
+        this->mDroppedBytes += (long)(Offset - this->mOffset);
+        WARNING("Live stream client is too slow, dropped %lld bytes of the timeshift", (long long)(Offset - this->mOffset));
+        this->mOffset = Offset;
+        return true;
+    }
+    uint64_t Position = cLiveBufferRef(this->mReceiver)->resync();
+    this->mDroppedBytes += (long)(Position - this->mPosition) * TS_SIZE;
+    WARNING("Live stream client is too slow, dropped %lld packets", (long long)(Position - this->mPosition));
+    this->mPosition = Position;
+    this->mSyncStart = Position;
+    this->mSynced = false;
+    return true;
+}
+
+int cLiveStream::copyPackets(uchar* Dest, int MaxPackets){
+    cLiveBufferRef Buffer(this->mReceiver);
+    // Without an independent frame for this long, the stream starts anyway
+    uint64_t SyncFallback = (uint64_t)(ISRADIO(this->mReceiver->getChannel()) ? 10000 : 120000) / TS_SIZE;
+    int PatPmtPackets = this->mPatPmtPackets;
+    const uchar* PatPmt = this->mPatPmt;
+    uint64_t Start = this->mPosition;
+    uint64_t Sequence = Start;
+    uint64_t Ready = Buffer->ready();
+    bool Synced = this->mSynced;
+    uchar PatCounter = this->mPatCounter;
+    uchar PmtCounter = this->mPmtCounter;
+    int Count = 0;
+
+    while (Sequence < Ready && Count < MaxPackets){
+        bool Independent = Buffer->flags(Sequence) & LIVEBUFFER_INDEPENDENT_FRAME;
+        if (!Synced){
+            if (!Independent && Sequence - this->mSyncStart < SyncFallback){
+                Sequence++;
+                continue;
+            }
+            Synced = true;
+        }
+        if (Independent && PatPmtPackets && Count + PatPmtPackets + 1 <= MaxPackets){
+            for (int i = 0; i < PatPmtPackets; i++){
+                uchar* Packet = Dest + Count++ * TS_SIZE;
+                memcpy(Packet, PatPmt + i * TS_SIZE, TS_SIZE);
+                uchar Counter = (i == 0) ? PatCounter++ : PmtCounter++;
+                Packet[3] = (Packet[3] & ~TS_CONT_CNT_MASK) | (Counter & TS_CONT_CNT_MASK);
+            }
+        }
+        else if (Independent && PatPmtPackets && Count){
+            // Leave the frame to the next read, so the PAT and PMT fit in front of it
+            break;
+        }
+        if (this->mPidFilter && !this->mPidFilter->allowed(TsPid(Buffer->packet(Sequence)))){
+            Sequence++;
+            continue;
+        }
+        memcpy(Dest + Count++ * TS_SIZE, Buffer->packet(Sequence++), TS_SIZE);
+    }
+    // The writer may have overwritten what we just copied
+    if (!Buffer->valid(Start)){
+        return -1;
+    }
+    this->mPosition = Sequence;
+    this->mSynced = Synced;
+    this->mPatCounter = PatCounter;
+    this->mPmtCounter = PmtCounter;
+    return Count;
+}
+
+int cLiveStream::read(char* buf, size_t buflen){
+    if(!this->mReceiver || this->mReceiver->isLost())
+        return -1;
+
+    int MaxPackets = (int)(buflen / TS_SIZE);
+    if (MaxPackets == 0){
+        ERROR("The buffer of %d bytes is too small for a transport stream packet", (int)buflen);
+        return -1;
+    }
+    // Wait until the buffer size is at least half the requested buffer length
+    int min_buffer_fillage = (this->mVType == 0) ? 6 : (RECEIVER_MIN_BUFFER_FILLAGE * 10); // as percentage*10 of buflen
+    int MinPackets = max(1, (int)(buflen * min_buffer_fillage/1000) / TS_SIZE);
+    if (this->mTimeshift){
+        int Bytes = this->readTimeshift(buf, MaxPackets * TS_SIZE, MinPackets * TS_SIZE);
+        if (Bytes != TIMESHIFT_ERROR){
+            return Bytes;
+        }
+    }
+    cTimeMs Waiting;
+    bool Waited = false;
+    int Count = 0;
+    int bytesRead = 0;
+    while (!bytesRead){
+        // The receiver may replace its buffer, so it is acquired for every try
+        cLiveBufferRef Buffer(this->mReceiver);
+        int Available = Buffer->available(this->mPosition);
+        if (Available >= 0 && Available < MinPackets){
+            // The receiver wakes us up as soon as new data arrives
+            if (!Waited){
+                this->mWaits++;
+                Waited = true;
+            }
+            int Remaining = RECEIVER_WAIT_ON_NODATA_TIMEOUT - (int)Waiting.Elapsed();
+            if (Remaining <= 0 && this->mReceiver->isWatched()){
+                // The watchdog either restores the data or gives up the receiver
+                Remaining = RECEIVER_WATCHDOG_INTERVAL;
+            }
+            if (Remaining <= 0){
+                double seconds = (RECEIVER_WAIT_ON_NODATA_TIMEOUT/1000);
+                ERROR("No data received for %4.2f seconds, aborting.", seconds);
+                this->mWaitTime += Waiting.Elapsed();
+                return 0;
+            }
+            Available = Buffer->wait(this->mPosition, MinPackets, Remaining);
+            if (this->mReceiver->isLost()){
+                MESSAGE(VERBOSE_LIVE_TV, "Lost device...");
+                this->mWaitTime += Waiting.Elapsed();
+                return 0;
+            }
+            if (Available >= 0 && Available < MinPackets){
+                continue;
+            }
+        }
+        if (Available >= 0){
+            Count = this->copyPackets((uchar*)buf, MaxPackets);
+        }
+        if (Available < 0 || Count < 0){
+            if (!this->handleOverrun()) return -1;
+            Count = 0;
+        }
+        bytesRead = Count * TS_SIZE;
+        if (bytesRead && this->mAudioPid){
+            bytesRead = this->extractAudio((uchar*)buf, bytesRead);
+        }
+    }
+    if (Waited){
+        this->mWaitTime += Waiting.Elapsed();
+    }
+
+    if (this->mTimeToFirstByte < 0){
+        this->mTimeToFirstByte = (int)(cTimeMs::Now() - this->mOpenTime);
+        MESSAGE(VERBOSE_LIVE_TV, "First bytes of the live stream after %d ms", this->mTimeToFirstByte);
+    }
+    MESSAGE(VERBOSE_BUFFERS, "Read %d bytes from live feed", bytesRead);
+    return bytesRead;
+}
+
+void cLiveStream::leaveTimeshift(){
+    ERROR("The timeshift file of channel \"%s\" failed, continuing with the live buffer", this->mReceiver->getChannel()->Name());
+    this->mTimeshift = NULL;
+    cLiveBufferRef Buffer(this->mReceiver);
+    this->mPosition = Buffer->gopStart();
+    this->mSyncStart = this->mPosition;
+    this->mSynced = false;
+    this->mAudioSynced = false;
+}
+
+int cLiveStream::readTimeshift(char* buf, int MaxBytes, int MinBytes){
+    cTimeMs Waiting;
+    bool Waited = false;
+    int Bytes = 0;
+    while (!Bytes){
+        int Available = this->mTimeshift->available(this->mOffset);
+        if (Available >= 0 && Available < MinBytes){
+            if (!Waited){
+                this->mWaits++;
+                Waited = true;
+            }
+            int Remaining = RECEIVER_WAIT_ON_NODATA_TIMEOUT - (int)Waiting.Elapsed();
+            if (Remaining <= 0 && this->mReceiver->isWatched()){
+                // The watchdog either restores the data or gives up the receiver
+                Remaining = RECEIVER_WATCHDOG_INTERVAL;
+            }
+            if (Remaining <= 0){
+                ERROR("No data received for %4.2f seconds, aborting.", (double)(RECEIVER_WAIT_ON_NODATA_TIMEOUT/1000));
+                this->mWaitTime += Waiting.Elapsed();
+                return 0;
+            }
+            Available = this->mTimeshift->wait(this->mOffset, MinBytes, Remaining);
+            if (this->mReceiver->isLost()){
+                MESSAGE(VERBOSE_LIVE_TV, "Lost device...");
+                this->mWaitTime += Waiting.Elapsed();
+                return 0;
+            }
+            if (Available >= 0 && Available < MinBytes){
+                continue;
+            }
+        }
+        if (Available >= 0){
+            Bytes = this->mTimeshift->read(this->mOffset, (uchar*)buf, MaxBytes);
+        }
+        if (Available == TIMESHIFT_ERROR || Bytes == TIMESHIFT_ERROR){
+            // A failed file stays failed, so it is no overrun
+            if (Waited){
+                this->mWaitTime += Waiting.Elapsed();
+            }
+            this->leaveTimeshift();
+            return TIMESHIFT_ERROR;
+        }
+        if (Available < 0 || Bytes < 0){
+            if (!this->handleOverrun()) return -1;
+            Bytes = 0;
+        }
+        else if (Bytes > 0){
+            this->mOffset += Bytes;
+            if (this->mAudioPid){
+                Bytes = this->extractAudio((uchar*)buf, Bytes);
+            }
+            else if (this->mPidFilter){
+                Bytes = this->filterPackets((uchar*)buf, Bytes);
+            }
+        }
+    }
+    if (Waited){
+        this->mWaitTime += Waiting.Elapsed();
+    }
+    if (this->mTimeToFirstByte < 0){
+        this->mTimeToFirstByte = (int)(cTimeMs::Now() - this->mOpenTime);
+        MESSAGE(VERBOSE_LIVE_TV, "First bytes of the live stream after %d ms", this->mTimeToFirstByte);
+    }
+    MESSAGE(VERBOSE_BUFFERS, "Read %d bytes from the timeshift", Bytes);
+    return Bytes;
+}
+
+int cLiveStream::filterPackets(uchar* Data, int Length){
+    int Out = 0;
+    for (int In = 0; In + TS_SIZE <= Length; In += TS_SIZE){
+        uchar* Packet = Data + In;
+        int Pid = TsPid(Packet);
+        if (Pid == this->mPmtPid){
+            // Every packet of the original PMT is replaced by one of the
+            // rewritten PMT, which never needs more packets
+            if (TsPayloadStart(Packet)){
+                this->mPmtIndex = 0;
+            }
+            int Index = 1 + this->mPmtIndex++;
+            if (Index >= this->mPatPmtPackets) continue;
+            memcpy(Data + Out, this->mPatPmt + Index * TS_SIZE, TS_SIZE);
+            TsSetContinuityCounter(Data + Out, this->mPmtCounter++);
+            Out += TS_SIZE;
+        }
+        else if (Pid == PATPID || this->mPidFilter->allowed(Pid)){
+            if (In != Out){
+                memmove(Data + Out, Packet, TS_SIZE);
+            }
+            Out += TS_SIZE;
+        }
+    }
+    return Out;
+}
+
+int cLiveStream::extractAudio(uchar* Data, int Length){
+    int Out = 0;
+    for (int In = 0; In + TS_SIZE <= Length; In += TS_SIZE){
+        uchar* Packet = Data + In;
+        if (TsPid(Packet) != this->mAudioPid || !TsHasPayload(Packet)){
+            continue;
+        }
+        int Offset = TsPayloadOffset(Packet);
+        if (TsPayloadStart(Packet)){
+            // Skip the PES header, it must be complete in the first packet
+            const uchar* Pes = Packet + Offset;
+            if (Offset + 9 > TS_SIZE || Pes[0] || Pes[1] || Pes[2] != 1 || Offset + PesPayloadOffset(Pes) > TS_SIZE){
+                this->mAudioSynced = false;
+                continue;
+            }
+            Offset += PesPayloadOffset(Pes);
+            this->mAudioSynced = true;
+        }
+        else if (!this->mAudioSynced){
+            continue;
+        }
+        memmove(Data + Out, Packet + Offset, TS_SIZE - Offset);
+        Out += TS_SIZE - Offset;
+    }
+    return Out;
+}
+
+int cLiveStream::seek(off_t offset, int origin){
+    if(!this->mTimeshift){
+        ERROR("Seeking not supported on broadcasts");
+        return 0;
+    }
+    uint64_t Start = this->mTimeshift->start();
+    uint64_t Length = this->mTimeshift->length();
+    off64_t Offset;
+    switch(origin){
+        case SEEK_SET:
+            Offset = offset;
+            break;
+        case SEEK_CUR:
+            Offset = (off64_t)this->mOffset + offset;
+            break;
+        case SEEK_END:
+            Offset = (off64_t)Length + offset;
+            break;
+        default:
+            ERROR("Seek operation invalid");
+            return -1;
+    }
+    if(Offset < (off64_t)Start){
+        ERROR("Seeking to %lld failed, the timeshift starts at %llu", (long long)Offset, (unsigned long long)Start);
+        return -1;
+    }
+    // Continue at the live edge, if the client is ahead of the broadcast
+    if(Offset > (off64_t)Length){
+        Offset = (off64_t)Length;
+    }
+    // The timeshift consists of whole transport stream packets
+    this->mOffset = (uint64_t)(Offset - Offset % TS_SIZE);
+    this->mAudioSynced = false;
+    MESSAGE(VERBOSE_LIVE_TV, "Seeking to %llu in the timeshift of %llu to %llu", (unsigned long long)this->mOffset,
+            (unsigned long long)Start, (unsigned long long)Length);
+    return 0;
+}
+
+int cLiveStream::write(char*, size_t){
+    ERROR("Writing not allowed on broadcasts");
+    return 0;
+}
+
+void cLiveStream::close(){
+    if(!this->mReceiver) return;
+
+    MESSAGE(VERBOSE_LIVE_TV, "Live stream statistics: first byte after %d ms, waited %ld times for %llu ms in total",
+            this->mTimeToFirstByte, this->mWaits, (unsigned long long)this->mWaitTime);
+    if(this->mOverruns){
+        MESSAGE(VERBOSE_LIVE_TV, "Live stream was overrun %d times, %ld bytes dropped", this->mOverruns, this->mDroppedBytes);
+    }
+    cLiveReceivers::getInstance()->releaseReceiver(this->mReceiver);
+    this->mReceiver = NULL;
+    MESSAGE(VERBOSE_LIVE_TV, "Live stream closed.");
+}
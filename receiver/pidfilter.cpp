@@ -0,0 +1,137 @@
+/*
+ * File:   pidfilter.cpp
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#include <stdlib.h>
+#include <ctype.h>
+#include "pidfilter.h"
+
+cPidFilter::cPidFilter(){
+    memset(this->mAllowed, 0, sizeof(this->mAllowed));
+    this->mAudioTracks = 0;
+}
+
+cPidFilter::~cPidFilter(){}
+
+void cPidFilter::allow(int Pid){
+    if(Pid > 0 && Pid < MAXPID){
+        this->mAllowed[Pid] = true;
+    }
+}
+
+cPidFilter* cPidFilter::newInstance(const cChannel* Channel, const char* Selection){
+    if(!Channel || !Selection || !*Selection){
+        return NULL;
+    }
+    cPidFilter* Filter = new cPidFilter;
+    Filter->allow(Channel->Vpid());
+    Filter->allow(Channel->Ppid());
+
+    char* Items = strdup(Selection);
+    char* Save = NULL;
+    for(char* Item = strtok_r(Items, ",", &Save); Item; Item = strtok_r(NULL, ",", &Save)){
+        int Pid = 0;
+        if(isdigit(*Item)){
+            int Wanted = atoi(Item);
+            for(int i = 0; !Pid && Channel->Apid(i); i++){
+                if(Channel->Apid(i) == Wanted) Pid = Wanted;
+            }
+            for(int i = 0; !Pid && Channel->Dpid(i); i++){
+                if(Channel->Dpid(i) == Wanted) Pid = Wanted;
+            }
+        }
+        else {
+            for(int i = 0; !Pid && Channel->Apid(i); i++){
+                if(!strncasecmp(Channel->Alang(i), Item, 3)) Pid = Channel->Apid(i);
+            }
+            for(int i = 0; !Pid && Channel->Dpid(i); i++){
+                if(!strncasecmp(Channel->Dlang(i), Item, 3)) Pid = Channel->Dpid(i);
+            }
+        }
+        if(Pid){
+            MESSAGE(VERBOSE_LIVE_TV, "Selected audio PID %d for '%s'", Pid, Item);
+            Filter->allow(Pid);
+            Filter->mAudioTracks++;
+        }
+        else {
+            WARNING("Channel \"%s\" has no audio track '%s'", Channel->Name(), Item);
+        }
+    }
+    free(Items);
+
+    if(!Filter->mAudioTracks){
+        delete Filter;
+        return NULL;
+    }
+    return Filter;
+}
+
+int cPidFilter::rewritePmt(const uchar* Pmt, int Packets, uchar* Dest){
+    if(Packets < 1 || !TsPayloadStart(Pmt)){
+        return 0;
+    }
+    // Reassemble the section from the payload of the packets
+    uchar Section[MAX_PMT_TS * TS_SIZE];
+    int Length = 0;
+    for(int i = 0; i < Packets; i++){
+        const uchar* Packet = Pmt + i * TS_SIZE;
+        int Offset = TsPayloadOffset(Packet);
+        if(i == 0){
+            Offset += 1 + Packet[Offset]; // the pointer field
+        }
+        if(Offset < TS_SIZE){
+            memcpy(Section + Length, Packet + Offset, TS_SIZE - Offset);
+            Length += TS_SIZE - Offset;
+        }
+    }
+    if(Length < 16){
+        return 0;
+    }
+    int SectionLength = 3 + (((Section[1] & 0x0F) << 8) | Section[2]);
+    int ProgramInfoLength = ((Section[10] & 0x0F) << 8) | Section[11];
+    int End = SectionLength - 4; // without the CRC
+    if(SectionLength > Length || 12 + ProgramInfoLength > End){
+        return 0;
+    }
+    // Keep the elementary streams which are selected
+    int In = 12 + ProgramInfoLength;
+    int Out = In;
+    while(In + 5 <= End){
+        int Pid = ((Section[In + 1] & TS_PID_MASK_HI) << 8) | Section[In + 2];
+        int Entry = 5 + (((Section[In + 3] & 0x0F) << 8) | Section[In + 4]);
+        if(In + Entry > End){
+            return 0;
+        }
+        if(this->allowed(Pid)){
+            memmove(Section + Out, Section + In, Entry);
+            Out += Entry;
+        }
+        In += Entry;
+    }
+    SectionLength = Out + 4 - 3;
+    Section[1] = (Section[1] & 0xF0) | ((SectionLength >> 8) & 0x0F);
+    Section[2] = SectionLength & 0xFF;
+    Out += this->MakeCRC(Section + Out, Section, Out);
+
+    // Split the section into packets again
+    int Count = 0;
+    for(int Done = 0; Done < Out; Count++){
+        uchar* Packet = Dest + Count * TS_SIZE;
+        memset(Packet, 0xFF, TS_SIZE);
+        Packet[0] = TS_SYNC_BYTE;
+        Packet[1] = (Pmt[1] & TS_PID_MASK_HI) | (Count ? 0 : TS_PAYLOAD_START);
+        Packet[2] = Pmt[2];
+        Packet[3] = TS_PAYLOAD_EXISTS;
+        int Offset = 4;
+        if(Count == 0){
+            Packet[Offset++] = 0x00; // the pointer field
+        }
+        int Bytes = min(Out - Done, TS_SIZE - Offset);
+        memcpy(Packet + Offset, Section + Done, Bytes);
+        Done += Bytes;
+    }
+    return Count;
+}
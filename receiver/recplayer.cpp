@@ -3,41 +3,58 @@
  * Author: savop
  * Author: J.Huber, IRT GmbH
  * Created on 8. Juni 2009, 11:57
- * Last modification: April 9, 2013
+ * Last modification: October 17, 2026
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
 #include <vdr/recording.h>
 #include <vdr/tools.h>
 #include "recplayer.h"
+#include "marktable.h"
 
 cRecordingPlayer *cRecordingPlayer::newInstance(cRecording* Recording){
     if(Recording->IsPesRecording()){
         ERROR("Sorry, but only TS is supported, yet!");
         return NULL;
     }
+    cSegmentedFile* File = cSegmentedFile::newInstance(Recording->FileName(), Recording->IsPesRecording());
+    if(!File){
+        return NULL;
+    }
 
-    cRecordingPlayer *Player = new cRecordingPlayer(Recording);
+    cRecordingPlayer *Player = new cRecordingPlayer(Recording, File);
     return Player;
 }
 cRecordingPlayer::~cRecordingPlayer() {
-    delete this->mRecordingFile;
-    delete [] this->mLastOffsets;
+    delete this->mFile;
 }
 
-cRecordingPlayer::cRecordingPlayer(cRecording *Recording) : mRecording(Recording) {
+cRecordingPlayer::cRecordingPlayer(cRecording *Recording, cSegmentedFile* File) : mRecording(Recording), mFile(File) {
     MESSAGE(VERBOSE_SDK, "Created Recplayer");
+    this->mStart = 0;
+    this->mFollow = isRecording(Recording);
+    if(this->mFollow){
+        MESSAGE(VERBOSE_RECORDS, "Following recording %s", Recording->Name());
+    }
+}
 
-    this->mRecordingFile = new cFileName(this->mRecording->FileName(), false, false, this->mRecording->IsPesRecording());
-    this->mLastOffsets = new off_t[((this->mRecording->IsPesRecording())?VDR_MAX_FILES_PER_PESRECORDING:VDR_MAX_FILES_PER_TSRECORDING)+1];
-    this->scanLastOffsets();
+bool cRecordingPlayer::isRecording(const cRecording* Recording){
+    // The record controls of VDR are not safe outside of its main thread, but
+    // the recorder writes the index with every frame
+    cString FileName = cString::sprintf("%s/%s", Recording->FileName(), Recording->IsPesRecording() ? "index.vdr" : "index");
+    struct stat Stat;
+    if(stat(FileName, &Stat) < 0){
+        return false;
+    }
+    return time(NULL) - Stat.st_mtime < RECORDING_INDEX_TIMEOUT;
 }
 
 void cRecordingPlayer::open(UpnpOpenFileMode){
-    // Open() does not work?!
-    this->mCurrentFile = this->mRecordingFile->SetOffset(1);
-    if(this->mCurrentFile){
+    if(this->mFile->seek(this->mStart)){
         MESSAGE(VERBOSE_RECORDS, "Record player opened");
     }
     else {
@@ -46,7 +63,7 @@ void cRecordingPlayer::open(UpnpOpenFileMode){
 }
 
 void cRecordingPlayer::close(){
-    this->mRecordingFile->Close();
+    this->mFile->close();
 }
 
 int cRecordingPlayer::write(char*, size_t){
@@ -55,70 +72,111 @@ int cRecordingPlayer::write(char*, size_t){
 }
 
 int cRecordingPlayer::read(char* buf, size_t buflen){
-    if(!this->mCurrentFile){
-        ERROR("Current part of record is not open");
-        return -1;
-    }
     MESSAGE(VERBOSE_RECORDS, "Reading %d from record", buflen);
-    int bytesread = 0;
-    while((bytesread = this->mCurrentFile->Read(buf, buflen)) == 0){ // EOF, try next file
-        if(!(this->mCurrentFile = this->mRecordingFile->NextFile())){
-            // no more files to read... finished!
-            break;
+    // The segments are read straight into the buffer of the webserver
+    int bytesread = this->mFile->read(buf, this->mFile->packetLength(buflen));
+    if(bytesread != 0 || !this->mFollow){
+        return bytesread;
+    }
+    // Wait for the recording to grow
+    cTimeMs Waiting;
+    int Delay = RECORDING_FOLLOW_DELAY;
+    while(Waiting.Elapsed() < RECORDING_FOLLOW_TIMEOUT){
+        bool Recording = isRecording(this->mRecording);
+        if(this->mFile->refresh() && (bytesread = this->mFile->read(buf, this->mFile->packetLength(buflen))) != 0){
+            return bytesread;
+        }
+        if(!Recording){
+            MESSAGE(VERBOSE_RECORDS, "Recording %s has finished", this->mRecording->Name());
+            this->mFollow = false;
+            return 0;
         }
+        cCondWait::SleepMs(Delay);
+        Delay = min(Delay * 2, RECORDING_FOLLOW_MAX_DELAY);
     }
-    return bytesread;
+    WARNING("Recording %s did not grow for %d seconds", this->mRecording->Name(), RECORDING_FOLLOW_TIMEOUT / 1000);
+    return 0;
 }
 
 int cRecordingPlayer::seek(off_t offset, int origin){
-    if(!this->mCurrentFile){
-        ERROR("Current part of record is not open");
-        return -1;
-    }
-    
     MESSAGE(VERBOSE_RECORDS, "Seeking...");
 
-    off_t relativeOffset = 0;
-    off_t curpos = this->mCurrentFile->Seek(0, SEEK_CUR); // this should not change anything
-    int index;
     // recalculate the absolute position in the record
     switch(origin){
         case SEEK_END:
-            offset = this->mLastOffsets[this->mLastFileNumber] + offset;
+            offset = this->mFile->size() + offset;
             break;
         case SEEK_CUR:
-            offset = this->mLastOffsets[this->mRecordingFile->Number()-1] + curpos +  offset;
+            offset = this->mFile->position() + offset;
             break;
         case SEEK_SET:
-            // Nothing to change
+            // The file starts at the start time
+            offset = this->mStart + offset;
             break;
         default:
             ERROR("Seek operation invalid");
             return -1;
     }
-    // finally, we can seek
-    // TODO: binary search
-    for(index = 1; this->mLastOffsets[index]; index++){
-        if(this->mLastOffsets[index-1] <= offset && offset <= this->mLastOffsets[index]){
-            relativeOffset = offset - this->mLastOffsets[index-1];
-            break;
+    if(offset < this->mStart || !this->mFile->seek(offset)){
+        ERROR("Seek position %lld is out of the recording", (long long)offset);
+        return -1;
+    }
+    return 0;
+}
+
+bool cRecordingPlayer::parseTime(const char* Npt, double* Seconds){
+    // The time is either seconds or hours:minutes:seconds
+    *Seconds = 0;
+    char* End = NULL;
+    for(const char* Field = Npt; ; Field = End + 1){
+        double Value = strtod(Field, &End);
+        if(End == Field || Value < 0){
+            ERROR("Invalid normal play time '%s'", Npt);
+            return false;
         }
+        *Seconds = *Seconds * 60 + Value;
+        if(*End != ':') break;
     }
-    if(!(this->mCurrentFile = this->mRecordingFile->SetOffset(index, relativeOffset))){
-        // seeking failed!!! should never happen.
-        this->mCurrentFile = this->mRecordingFile->SetOffset(1);
-        return -1;
+    if(*End){
+        ERROR("Invalid normal play time '%s'", Npt);
+        return false;
     }
+    return true;
+}
 
-    return 0;
+bool cRecordingPlayer::setStartTime(const char* Npt){
+    double Seconds = 0;
+    if(!parseTime(Npt, &Seconds)){
+        return false;
+    }
+    return this->setStartFrame((int)(Seconds * this->mRecording->FramesPerSecond()));
 }
 
-void cRecordingPlayer::scanLastOffsets(){
-    // rewind
-    this->mCurrentFile = this->mRecordingFile->SetOffset(1);
-    for(int i = 1; (this->mCurrentFile = this->mRecordingFile->NextFile()); i++){
-        this->mLastOffsets[i] = this->mLastOffsets[i-1] + this->mCurrentFile->Seek(0, SEEK_END);
-        this->mLastFileNumber = this->mRecordingFile->Number();
+bool cRecordingPlayer::setStartMark(const char* Mark){
+    cMarkTable Marks;
+    int Number = atoi(Mark);
+    if(!cMarkTables::getInstance()->get(this->mRecording->FileName(), &Marks) || Number < 1 || Number > Marks.count()){
+        ERROR("Recording %s has no mark '%s'", this->mRecording->Name(), Mark);
+        return false;
     }
+    return this->setStartFrame(Marks.frame(Number));
 }
 
+bool cRecordingPlayer::setStartFrame(int Frame){
+    cIndexFile Index(this->mRecording->FileName(), false, this->mRecording->IsPesRecording());
+    if(!Index.Ok() || Index.Last() < 0){
+        ERROR("Recording %s has no index", this->mRecording->Name());
+        return false;
+    }
+    Frame = min(Frame, Index.Last());
+    uint16_t FileNumber = 0;
+    off_t FileOffset = 0;
+    // Searching backwards from the next frame finds the frame itself, if it is independent
+    if(Index.GetNextIFrame(Frame + 1, false, &FileNumber, &FileOffset) < 0 || this->mFile->offsetOf(FileNumber, FileOffset) < 0){
+        ERROR("No independent frame at frame %d in recording %s", Frame, this->mRecording->Name());
+        return false;
+    }
+    this->mStart = this->mFile->offsetOf(FileNumber, FileOffset);
+    MESSAGE(VERBOSE_RECORDS, "Starting recording at frame %d, offset %lld", Frame, (long long)this->mStart);
+    return true;
+}
@@ -0,0 +1,423 @@
+/*
+ * File:   segmentedfile.cpp
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <vdr/recording.h>
+#include <vdr/tools.h>
+#include <vdr/remux.h>
+#include "segmentedfile.h"
+#include "config.h"
+
+cSegmentTable::cSegmentTable(const char* FileName) : mPath(FileName){
+    // The first segment starts at 0
+    this->mEnds.push_back(0);
+    this->mDirectoryTime = 0;
+    this->mLastTime = 0;
+    this->mChecked = 0;
+    this->mRefs = 0;
+    this->mCached = false;
+    this->mPesRecording = false;
+}
+
+bool cSegmentTable::scan(bool IsPesRecording){
+    struct stat Stat;
+    if(stat(this->mPath.c_str(), &Stat) < 0){
+        ERROR("Failed to scan %s: %s", this->mPath.c_str(), strerror(errno));
+        return false;
+    }
+    this->mDirectoryTime = Stat.st_mtime;
+    this->mPesRecording = IsPesRecording;
+    int Maximum = IsPesRecording ? VDR_MAX_FILES_PER_PESRECORDING : VDR_MAX_FILES_PER_TSRECORDING;
+    for(int Number = 1; Number <= Maximum; Number++){
+        // The same names as cFileName uses
+        cString Name = cString::sprintf(IsPesRecording ? "%s/%03d.vdr" : "%s/%05d.ts", this->mPath.c_str(), Number);
+        if(stat(Name, &Stat) < 0) break;
+        this->mNames.push_back(*Name);
+        this->mEnds.push_back(this->mEnds.back() + Stat.st_size);
+        this->mLastTime = Stat.st_mtime;
+    }
+    this->mChecked = cTimeMs::Now();
+    return !this->mNames.empty();
+}
+
+bool cSegmentTable::fresh(){
+    uint64_t Now = cTimeMs::Now();
+    if(Now - this->mChecked < SEGMENT_TABLE_TTL){
+        return true;
+    }
+    // New segments change the directory, a growing segment only itself
+    struct stat Stat;
+    if(stat(this->mPath.c_str(), &Stat) < 0 || Stat.st_mtime != this->mDirectoryTime){
+        return false;
+    }
+    if(stat(this->name(this->segments()), &Stat) < 0 || Stat.st_mtime != this->mLastTime ||
+       Stat.st_size != this->end(this->segments()) - this->start(this->segments())){
+        return false;
+    }
+    this->mChecked = Now;
+    return true;
+}
+
+int cSegmentTable::segmentOf(off_t Offset) const {
+    // The first segment whose end is behind the offset
+    int Low = 1, High = this->segments();
+    while(Low < High){
+        int Middle = (Low + High) / 2;
+        if(Offset < this->mEnds[Middle]){
+            High = Middle;
+        }
+        else {
+            Low = Middle + 1;
+        }
+    }
+    return Low;
+}
+
+cSegmentTables* cSegmentTables::mInstance = NULL;
+
+cSegmentTables::cSegmentTables(){
+    this->mHits = 0;
+    this->mMisses = 0;
+    this->mStalls = 0;
+    this->mStallTime = 0;
+}
+
+cSegmentTables* cSegmentTables::getInstance(){
+    if(cSegmentTables::mInstance == NULL)
+        cSegmentTables::mInstance = new cSegmentTables();
+
+    return cSegmentTables::mInstance;
+}
+
+cSegmentTable* cSegmentTables::acquire(const char* FileName, bool IsPesRecording){
+    cMutexLock MutexLock(&this->mMutex);
+    std::map<std::string, cSegmentTable*>::iterator It = this->mTables.find(FileName);
+    if(It != this->mTables.end()){
+        cSegmentTable* Table = It->second;
+        if(Table->fresh()){
+            this->mHits++;
+            Table->mRefs++;
+            return Table;
+        }
+        // Streams which still use the old table keep it until they end
+        MESSAGE(VERBOSE_RECORDS, "%s was modified, scanning it again", FileName);
+        this->mTables.erase(It);
+        Table->mCached = false;
+        if(!Table->mRefs){
+            delete Table;
+        }
+    }
+    this->mMisses++;
+    cSegmentTable* Table = new cSegmentTable(FileName);
+    if(!Table->scan(IsPesRecording)){
+        ERROR("No files found in %s", FileName);
+        delete Table;
+        return NULL;
+    }
+    MESSAGE(VERBOSE_RECORDS, "%s has %d files with %lld bytes", FileName, Table->segments(), (long long)Table->size());
+    Table->mRefs = 1;
+    Table->mCached = true;
+    this->mTables[FileName] = Table;
+    this->trim();
+    return Table;
+}
+
+void cSegmentTables::release(cSegmentTable* Table){
+    cMutexLock MutexLock(&this->mMutex);
+    if(--Table->mRefs == 0 && !Table->mCached){
+        delete Table;
+    }
+}
+
+void cSegmentTables::stalled(uint64_t Time){
+    cMutexLock MutexLock(&this->mMutex);
+    this->mStalls++;
+    this->mStallTime += Time;
+}
+
+void cSegmentTables::trim(){
+    while(this->mTables.size() > SEGMENT_TABLE_CACHE){
+        // Drop the unused table which was checked longest ago
+        std::map<std::string, cSegmentTable*>::iterator Oldest = this->mTables.end();
+        for(std::map<std::string, cSegmentTable*>::iterator It = this->mTables.begin(); It != this->mTables.end(); It++){
+            if(!It->second->mRefs && (Oldest == this->mTables.end() || It->second->mChecked < Oldest->second->mChecked)){
+                Oldest = It;
+            }
+        }
+        if(Oldest == this->mTables.end()) break;
+        delete Oldest->second;
+        this->mTables.erase(Oldest);
+    }
+}
+
+cAlignedBuffers* cAlignedBuffers::mInstance = NULL;
+
+cAlignedBuffers* cAlignedBuffers::getInstance(){
+    if(cAlignedBuffers::mInstance == NULL)
+        cAlignedBuffers::mInstance = new cAlignedBuffers();
+
+    return cAlignedBuffers::mInstance;
+}
+
+char* cAlignedBuffers::get(){
+    cMutexLock MutexLock(&this->mMutex);
+    if(!this->mBuffers.empty()){
+        char* Buffer = this->mBuffers.back();
+        this->mBuffers.pop_back();
+        return Buffer;
+    }
+    void* Buffer = NULL;
+    if(posix_memalign(&Buffer, DIRECT_IO_ALIGNMENT, DIRECT_IO_BUFFER)){
+        ERROR("Failed to allocate a buffer for direct reads");
+        return NULL;
+    }
+    return (char*)Buffer;
+}
+
+void cAlignedBuffers::put(char* Buffer){
+    if(!Buffer){
+        return;
+    }
+    cMutexLock MutexLock(&this->mMutex);
+    if(this->mBuffers.size() < DIRECT_IO_POOL){
+        this->mBuffers.push_back(Buffer);
+    }
+    else {
+        free(Buffer);
+    }
+}
+
+cSegmentedFile* cSegmentedFile::newInstance(const char* FileName, bool IsPesRecording){
+    cSegmentTable* Table = cSegmentTables::getInstance()->acquire(FileName, IsPesRecording);
+    if(!Table){
+        return NULL;
+    }
+    return new cSegmentedFile(Table);
+}
+
+cSegmentedFile::cSegmentedFile(cSegmentTable* Table) : mTable(Table){
+    this->mPosition = 0;
+    this->mNumber = 0;
+    this->mFile = -1;
+    this->mAheadNumber = 0;
+    this->mAheadFile = -1;
+    this->mReadAhead = (off_t)cUPnPConfig::get()->mReadAhead * 1024;
+    this->mAdvised = 0;
+    this->mStalls = 0;
+    this->mStallTime = 0;
+    this->mBytesRead = 0;
+    this->mDirectBuffer = NULL;
+    this->mDirect = false;
+    this->mBufferNumber = 0;
+    this->mBufferStart = 0;
+    this->mBufferLength = 0;
+    if(cUPnPConfig::get()->mDirectIO){
+        this->mDirectBuffer = cAlignedBuffers::getInstance()->get();
+        // The kernel cannot read ahead of direct reads
+        if(this->mDirectBuffer) this->mReadAhead = 0;
+    }
+}
+
+cSegmentedFile::~cSegmentedFile(){
+    this->close();
+    cSegmentTables::getInstance()->release(this->mTable);
+    cAlignedBuffers::getInstance()->put(this->mDirectBuffer);
+    if(this->mStalls){
+        MESSAGE(VERBOSE_RECORDS, "Stream of %lld bytes stalled %ld times for %llu ms", (long long)this->mBytesRead,
+                this->mStalls, (unsigned long long)this->mStallTime);
+    }
+}
+
+void cSegmentedFile::close(){
+    if(this->mFile >= 0){
+        ::close(this->mFile);
+    }
+    if(this->mAheadFile >= 0){
+        ::close(this->mAheadFile);
+    }
+    this->mFile = -1;
+    this->mNumber = 0;
+    this->mAheadFile = -1;
+    this->mAheadNumber = 0;
+    this->mBufferNumber = 0;
+    // The page cache may have dropped the advised data meanwhile
+    this->mAdvised = this->mPosition;
+}
+
+bool cSegmentedFile::openSegment(int Number){
+    int File = -1;
+    if(Number == this->mAheadNumber){
+        // The read-ahead opened the segment already
+        File = this->mAheadFile;
+        this->mAheadFile = -1;
+        this->mAheadNumber = 0;
+        this->mDirect = false;
+    }
+    else {
+        const char* Name = this->mTable->name(Number);
+        if(this->mDirectBuffer){
+            File = ::open(Name, O_RDONLY | O_LARGEFILE | O_DIRECT);
+            if(File < 0 && errno == EINVAL){
+                WARNING("%s cannot be read directly, reading it through the page cache", Name);
+            }
+        }
+        this->mDirect = File >= 0;
+        if(File < 0){
+            File = ::open(Name, O_RDONLY | O_LARGEFILE);
+        }
+        if(File < 0){
+            ERROR("Failed to open %s: %s", Name, strerror(errno));
+            return false;
+        }
+        if(!this->mDirect){
+            posix_fadvise(File, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+    }
+    if(this->mFile >= 0){
+        ::close(this->mFile);
+    }
+    this->mFile = File;
+    this->mNumber = Number;
+    return true;
+}
+
+int cSegmentedFile::openAhead(int Number){
+    if(Number == this->mNumber){
+        return this->mFile;
+    }
+    if(Number != this->mAheadNumber){
+        if(this->mAheadFile >= 0){
+            ::close(this->mAheadFile);
+        }
+        this->mAheadNumber = 0;
+        this->mAheadFile = ::open(this->mTable->name(Number), O_RDONLY | O_LARGEFILE);
+        if(this->mAheadFile < 0){
+            return -1;
+        }
+        posix_fadvise(this->mAheadFile, 0, 0, POSIX_FADV_SEQUENTIAL);
+        this->mAheadNumber = Number;
+    }
+    return this->mAheadFile;
+}
+
+void cSegmentedFile::readAhead(){
+    if(this->mReadAhead <= 0 || this->mAdvised - this->mPosition > this->mReadAhead / 2){
+        return;
+    }
+    off_t From = max(this->mAdvised, this->mPosition);
+    off_t End = min(this->mPosition + this->mReadAhead, this->size());
+    while(From < End){
+        // The window may reach into the next segment
+        int Number = this->mTable->segmentOf(From);
+        off_t SegmentEnd = min(End, this->mTable->end(Number));
+        int File = this->openAhead(Number);
+        if(File < 0) break;
+        posix_fadvise(File, From - this->mTable->start(Number), SegmentEnd - From, POSIX_FADV_WILLNEED);
+        From = SegmentEnd;
+    }
+    this->mAdvised = From;
+}
+
+bool cSegmentedFile::refresh(){
+    cSegmentTable* Table = cSegmentTables::getInstance()->acquire(this->mTable->path(), this->mTable->isPesRecording());
+    if(!Table){
+        return false;
+    }
+    bool Grown = Table->size() > this->mTable->size();
+    // A segment keeps its number, so the open segments stay valid
+    cSegmentTables::getInstance()->release(this->mTable);
+    this->mTable = Table;
+    return Grown;
+}
+
+off_t cSegmentedFile::offsetOf(int Number, off_t Offset) const {
+    if(Number < 1 || Number > this->segments() || Offset < 0){
+        return -1;
+    }
+    return this->mTable->start(Number) + Offset;
+}
+
+size_t cSegmentedFile::packetLength(size_t Length) const {
+    size_t Rest = (size_t)((this->mPosition + Length) % TS_SIZE);
+    // Buffers smaller than a packet are filled anyway
+    return Length > Rest ? Length - Rest : Length;
+}
+
+bool cSegmentedFile::seek(off_t Position){
+    if(Position < 0 || Position > this->size()){
+        return false;
+    }
+    if(Position != this->mPosition){
+        // The window ahead of the old position is of no use any longer
+        this->mAdvised = Position;
+    }
+    this->mPosition = Position;
+    return true;
+}
+
+ssize_t cSegmentedFile::readSegment(char* Dest, size_t Length, off_t Offset){
+    if(!this->mDirect){
+        return pread(this->mFile, Dest, Length, Offset);
+    }
+    if(this->mBufferNumber != this->mNumber || Offset < this->mBufferStart || Offset >= this->mBufferStart + this->mBufferLength){
+        // Read the aligned block which contains the offset
+        off_t Start = Offset - Offset % DIRECT_IO_ALIGNMENT;
+        ssize_t Result = pread(this->mFile, this->mDirectBuffer, DIRECT_IO_BUFFER, Start);
+        if(Result < 0){
+            return Result;
+        }
+        this->mBufferNumber = this->mNumber;
+        this->mBufferStart = Start;
+        this->mBufferLength = Result;
+        if(Offset >= Start + Result){
+            return 0;
+        }
+    }
+    size_t Bytes = (size_t)min((off_t)Length, this->mBufferStart + this->mBufferLength - Offset);
+    memcpy(Dest, this->mDirectBuffer + (Offset - this->mBufferStart), Bytes);
+    return Bytes;
+}
+
+int cSegmentedFile::read(char* Dest, size_t Length){
+    cTimeMs Time;
+    size_t Read = 0;
+    while(Read < Length && this->mPosition < this->size()){
+        int Number = this->mTable->segmentOf(this->mPosition);
+        if(Number != this->mNumber && !this->openSegment(Number)){
+            return Read ? (int)Read : -1;
+        }
+        // Never read across the end of the segment
+        size_t Bytes = (size_t)min((off_t)(Length - Read), this->mTable->end(Number) - this->mPosition);
+        ssize_t Result = this->readSegment(Dest + Read, Bytes, this->mPosition - this->mTable->start(Number));
+        if(Result < 0){
+            if(errno == EINTR) continue;
+            ERROR("Failed to read %s: %s", this->mTable->name(Number), strerror(errno));
+            return Read ? (int)Read : -1;
+        }
+        if(Result == 0){
+            // The segment is shorter than it was when it was scanned
+            WARNING("Unexpected end of %s", this->mTable->name(Number));
+            break;
+        }
+        Read += Result;
+        this->mPosition += Result;
+    }
+    uint64_t Elapsed = Time.Elapsed();
+    if(Elapsed >= STREAM_STALL_THRESHOLD){
+        this->mStalls++;
+        this->mStallTime += Elapsed;
+        cSegmentTables::getInstance()->stalled(Elapsed);
+        MESSAGE(VERBOSE_BUFFERS, "Reading %d bytes took %llu ms", (int)Read, (unsigned long long)Elapsed);
+    }
+    this->mBytesRead += Read;
+    this->readAhead();
+    return (int)Read;
+}
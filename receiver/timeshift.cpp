@@ -0,0 +1,240 @@
+/*
+ * File:   timeshift.cpp
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <vdr/thread.h>
+#include "timeshift.h"
+#include "config.h"
+#include "../upnp.h"
+
+cTimeshiftFile* cTimeshiftFile::newInstance(const cChannel* Channel, off64_t Size){
+    Size -= Size % TS_SIZE;
+    if(Size < RECEIVER_LIVEBUFFER_SIZE){
+        ERROR("The timeshift buffer of %lld bytes is too small", (long long)Size);
+        return NULL;
+    }
+    const char* Directory = (cUPnPConfig::get()->mLiveTimeshiftDir) ? cUPnPConfig::get()->mLiveTimeshiftDir : cPluginUpnp::getConfigDirectory();
+    cString FileName = cString::sprintf("%s/timeshift-%s.ts", Directory, *Channel->GetChannelID().ToString());
+    int File = ::open(FileName, O_RDWR | O_CREAT | O_TRUNC | O_LARGEFILE, 0600);
+    if(File < 0){
+        ERROR("Failed to create the timeshift file %s: %s", *FileName, strerror(errno));
+        return NULL;
+    }
+    // Nobody else needs the file, so it is removed as soon as it is closed
+    unlink(FileName);
+    MESSAGE(VERBOSE_LIVE_TV, "Timeshift file for channel \"%s\" created with %lld bytes", Channel->Name(), (long long)Size);
+    cTimeshiftFile* Timeshift = new cTimeshiftFile(File, Size);
+    Timeshift->Start();
+    return Timeshift;
+}
+
+cTimeshiftFile::cTimeshiftFile(int File, off64_t Size) : cThread("UPnP timeshift writer"), mFile(File), mSize(Size){
+    this->mRing = new cRingBufferLinear(RECEIVER_TIMESHIFT_RING, 0, false, "UPnP timeshift");
+    this->mRing->SetTimeouts(0, RECEIVER_TIMESHIFT_WAIT);
+    this->mQueued = 0;
+    this->mWritten = 0;
+    this->mStored = 0;
+    this->mPublishable = 0;
+    this->mPublished = 0;
+    this->mGopStart = 0;
+    this->mHasGop = false;
+    this->mFailed = false;
+    this->mDropping = false;
+    this->mDrops = 0;
+    this->mWakeups = 0;
+}
+
+cTimeshiftFile::~cTimeshiftFile(){
+    this->Cancel(3);
+    if(this->mDrops){
+        WARNING("The timeshift writer fell behind %d times", this->mDrops);
+    }
+    delete this->mRing;
+    if(this->mFile >= 0){
+        ::close(this->mFile);
+    }
+}
+
+bool cTimeshiftFile::write(const uchar* Data, int Length){
+    if(this->mFailed) return false;
+
+    if(!this->mDropping && this->mRing->Free() < Length){
+        // The disk is too slow, the file continues with the next independent frame
+        WARNING("Timeshift writer fell behind, dropping data up to the next independent frame");
+        this->mDropping = true;
+        this->mDrops++;
+    }
+    if(this->mDropping){
+        return false;
+    }
+    this->mRing->Put(Data, Length);
+    // Only this thread modifies the queued position
+    this->mQueued += Length;
+    return true;
+}
+
+void cTimeshiftFile::Action(void){
+    while(this->Running() && !this->mFailed){
+        int Count = 0;
+        uchar* Data = this->mRing->Get(Count);
+        if(!Data){
+            continue;
+        }
+        if(!this->store(Data, Count)){
+            // Readers must not wait for data which will never come
+            this->wakeup();
+            break;
+        }
+        this->mRing->Del(Count);
+        cMutexLock MutexLock(&this->mMutex);
+        this->mStored += Count;
+        this->publishStored();
+    }
+}
+
+bool cTimeshiftFile::store(const uchar* Data, int Length){
+    // Only this thread modifies the write position
+    uint64_t Offset = this->mWritten;
+    // Readers must know which part of the file is going to be overwritten
+    this->mMutex.Lock();
+    this->mWritten += Length;
+    this->mMutex.Unlock();
+    while(Length > 0){
+        off64_t Position = (off64_t)(Offset % this->mSize);
+        int Bytes = (int)min((off64_t)Length, this->mSize - Position);
+        ssize_t Written = pwrite(this->mFile, Data, Bytes, Position);
+        if(Written <= 0){
+            if(Written < 0 && errno == EINTR) continue;
+            ERROR("Failed to write the timeshift file: %s", strerror(errno));
+            this->mFailed = true;
+            return false;
+        }
+        Data += Written;
+        Length -= Written;
+        Offset += Written;
+    }
+    return true;
+}
+
+void cTimeshiftFile::markIndependentFrame(){
+    // Dropped data is resumed with a whole group of pictures
+    this->mDropping = false;
+    cMutexLock MutexLock(&this->mMutex);
+    this->mGopStart = this->mQueued;
+    this->mHasGop = true;
+}
+
+void cTimeshiftFile::publish(){
+    cMutexLock MutexLock(&this->mMutex);
+    this->mPublishable = this->mQueued;
+    this->publishStored();
+}
+
+void cTimeshiftFile::publishStored(){
+    uint64_t Published = min(this->mStored, this->mPublishable);
+    if(Published != this->mPublished){
+        this->mPublished = Published;
+        this->mDataReady.Broadcast();
+    }
+}
+
+uint64_t cTimeshiftFile::windowStart() const {
+    return this->mWritten > (uint64_t)this->mSize ? this->mWritten - this->mSize : 0;
+}
+
+int cTimeshiftFile::bytesAvailable(uint64_t Offset) const {
+    if(this->mFailed){
+        return TIMESHIFT_ERROR;
+    }
+    if(Offset < this->windowStart()){
+        return TIMESHIFT_OVERRUN;
+    }
+    return Offset < this->mPublished ? (int)min(this->mPublished - Offset, (uint64_t)INT_MAX) : 0;
+}
+
+int cTimeshiftFile::available(uint64_t Offset){
+    cMutexLock MutexLock(&this->mMutex);
+    return this->bytesAvailable(Offset);
+}
+
+int cTimeshiftFile::read(uint64_t Offset, uchar* Dest, int Length){
+    this->mMutex.Lock();
+    int Available = this->bytesAvailable(Offset);
+    this->mMutex.Unlock();
+    if(Available <= 0){
+        return Available;
+    }
+    Length = min(Length, Available);
+    int Read = 0;
+    while(Read < Length){
+        off64_t Position = (off64_t)((Offset + Read) % this->mSize);
+        int Bytes = (int)min((off64_t)(Length - Read), this->mSize - Position);
+        ssize_t Result = pread(this->mFile, Dest + Read, Bytes, Position);
+        if(Result <= 0){
+            if(Result < 0 && errno == EINTR) continue;
+            ERROR("Failed to read the timeshift file: %s", strerror(errno));
+            // The streams stop using the file
+            this->mFailed = true;
+            return TIMESHIFT_ERROR;
+        }
+        Read += Result;
+    }
+    // The writer may have overwritten what we just read
+    cMutexLock MutexLock(&this->mMutex);
+    if(Offset < this->windowStart()){
+        return TIMESHIFT_OVERRUN;
+    }
+    return Read;
+}
+
+int cTimeshiftFile::wait(uint64_t Offset, int Bytes, int TimeoutMs){
+    cMutexLock MutexLock(&this->mMutex);
+    cTimeMs Start;
+    int Wakeups = this->mWakeups;
+    while(true){
+        int Available = this->bytesAvailable(Offset);
+        int Remaining = TimeoutMs - (int)Start.Elapsed();
+        if(Available < 0 || Available >= Bytes || Wakeups != this->mWakeups || Remaining <= 0){
+            return Available;
+        }
+        this->mDataReady.TimedWait(this->mMutex, Remaining);
+    }
+}
+
+void cTimeshiftFile::wakeup(){
+    cMutexLock MutexLock(&this->mMutex);
+    this->mWakeups++;
+    this->mDataReady.Broadcast();
+}
+
+uint64_t cTimeshiftFile::start(){
+    cMutexLock MutexLock(&this->mMutex);
+    return this->windowStart();
+}
+
+uint64_t cTimeshiftFile::length(){
+    cMutexLock MutexLock(&this->mMutex);
+    return this->mPublished;
+}
+
+uint64_t cTimeshiftFile::gopStart(){
+    cMutexLock MutexLock(&this->mMutex);
+    if(!this->mHasGop || this->mGopStart < this->windowStart() || this->mGopStart > this->mPublished){
+        return this->mPublished;
+    }
+    return this->mGopStart;
+}
+
+uint64_t cTimeshiftFile::resync(){
+    cMutexLock MutexLock(&this->mMutex);
+    uint64_t Position = this->windowStart() + (uint64_t)(this->mSize / 4);
+    Position -= Position % TS_SIZE;
+    return min(Position, this->mPublished);
+}
@@ -0,0 +1,207 @@
+/*
+ * File:   trickplayer.cpp
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#include <stdlib.h>
+#include <vdr/tools.h>
+#include "trickplayer.h"
+#include "recplayer.h"
+
+cTrickPlayer* cTrickPlayer::newInstance(cRecording* Recording, const char* Speed){
+    int Value = parseSpeed(Speed);
+    if(!Value){
+        return NULL;
+    }
+    if(Recording->IsPesRecording()){
+        ERROR("Sorry, but only TS is supported, yet!");
+        return NULL;
+    }
+    cIndexFile* Index = new cIndexFile(Recording->FileName(), false, Recording->IsPesRecording());
+    if(!Index->Ok() || Index->Last() < 0){
+        ERROR("Recording %s has no index", Recording->Name());
+        delete Index;
+        return NULL;
+    }
+    cSegmentedFile* File = cSegmentedFile::newInstance(Recording->FileName(), Recording->IsPesRecording());
+    if(!File){
+        delete Index;
+        return NULL;
+    }
+    cTrickPlayer* Player = new cTrickPlayer(Recording, File, Index, Value);
+    if(!Player->readPatPmt()){
+        ERROR("Recording %s has no video for trick play", Recording->Name());
+        delete Player;
+        return NULL;
+    }
+    return Player;
+}
+
+cTrickPlayer::cTrickPlayer(cRecording* Recording, cSegmentedFile* File, cIndexFile* Index, int Speed)
+    : mRecording(Recording), mFile(File), mIndex(Index), mSpeed(Speed) {
+    // Only the frames are read, not the data between them
+    this->mFile->setReadAhead(0);
+    this->mStep = max(1, (int)(abs(Speed) * Recording->FramesPerSecond() / TRICK_FRAME_RATE));
+    this->mStart = Speed > 0 ? 0 : Index->Last();
+    this->mFrame = -1;
+    this->mPatPmtPackets = 0;
+    this->mPmtPid = -1;
+    this->mVpid = 0;
+    this->mBuffer = MALLOC(uchar, sizeof(this->mPatPmt) + TRICK_MAX_FRAME_SIZE);
+    this->mLength = 0;
+    this->mOffset = 0;
+    this->mPosition = 0;
+    this->mPatCounter = 0;
+    this->mPmtCounter = 0;
+    this->mVideoCounter = 0;
+    MESSAGE(VERBOSE_RECORDS, "Created trick player for %s at speed %d, every %d frames", Recording->Name(), Speed, this->mStep);
+}
+
+cTrickPlayer::~cTrickPlayer(){
+    free(this->mBuffer);
+    delete this->mFile;
+    delete this->mIndex;
+}
+
+int cTrickPlayer::parseSpeed(const char* Speed){
+    char* End = NULL;
+    long Value = strtol(Speed, &End, 10);
+    if(End == Speed || *End || Value == 0 || Value == 1 || labs(Value) > TRICK_MAX_SPEED){
+        ERROR("Invalid trick play speed '%s'", Speed);
+        return 0;
+    }
+    return (int)Value;
+}
+
+bool cTrickPlayer::setStartTime(const char* Npt){
+    double Seconds = 0;
+    if(!cRecordingPlayer::parseTime(Npt, &Seconds)){
+        return false;
+    }
+    this->mStart = min((int)(Seconds * this->mRecording->FramesPerSecond()), this->mIndex->Last());
+    MESSAGE(VERBOSE_RECORDS, "Starting trick play at %.1f seconds, frame %d", Seconds, this->mStart);
+    return true;
+}
+
+bool cTrickPlayer::readPatPmt(){
+    uchar Data[TRICK_HEADER_PACKETS * TS_SIZE];
+    if(!this->mFile->seek(0)){
+        return false;
+    }
+    int Length = this->mFile->read((char*)Data, sizeof(Data));
+    cPatPmtParser Parser;
+    for(int i = 0; i + TS_SIZE <= Length && !this->mVpid; i += TS_SIZE){
+        uchar* Packet = Data + i;
+        int Pid = TsPid(Packet);
+        if(Pid == PATPID && this->mPmtPid < 0){
+            Parser.ParsePat(Packet, TS_SIZE);
+            this->mPmtPid = Parser.PmtPid() ? Parser.PmtPid() : -1;
+            if(this->mPmtPid >= 0){
+                memcpy(this->mPatPmt, Packet, TS_SIZE);
+                this->mPatPmtPackets = 1;
+            }
+        }
+        else if(Pid == this->mPmtPid && this->mPatPmtPackets <= MAX_PMT_TS){
+            if(TsPayloadStart(Packet)){
+                // Start over with the first packet of the section
+                this->mPatPmtPackets = 1;
+            }
+            memcpy(this->mPatPmt + this->mPatPmtPackets++ * TS_SIZE, Packet, TS_SIZE);
+            Parser.ParsePmt(Packet, TS_SIZE);
+            this->mVpid = Parser.Vpid();
+        }
+    }
+    MESSAGE(VERBOSE_RECORDS, "Trick play of PID %d with %d PAT/PMT packets", this->mVpid, this->mPatPmtPackets);
+    return this->mVpid != 0;
+}
+
+void cTrickPlayer::appendPacket(const uchar* Packet){
+    uchar* Dest = this->mBuffer + this->mLength;
+    memmove(Dest, Packet, TS_SIZE);
+    int Pid = TsPid(Dest);
+    uchar &Counter = Pid == PATPID ? this->mPatCounter : Pid == this->mPmtPid ? this->mPmtCounter : this->mVideoCounter;
+    // Packets without payload repeat the counter of the previous packet
+    TsSetContinuityCounter(Dest, TsHasPayload(Dest) ? Counter++ : Counter - 1);
+    this->mLength += TS_SIZE;
+}
+
+bool cTrickPlayer::loadFrame(){
+    // The first frame is the one at or before the start
+    bool Forward = this->mSpeed > 0;
+    int Search = this->mFrame < 0 ? this->mStart + 1 : Forward ? this->mFrame + this->mStep - 1 : this->mFrame - this->mStep + 1;
+    uint16_t FileNumber = 0;
+    off_t FileOffset = 0;
+    int Length = 0;
+    int Frame = this->mIndex->GetNextIFrame(Search, this->mFrame < 0 ? false : Forward, &FileNumber, &FileOffset, &Length);
+    if(Frame < 0 || Frame == this->mFrame || Length <= 0){
+        MESSAGE(VERBOSE_RECORDS, "Trick play reached the %s of the recording", Forward ? "end" : "beginning");
+        return false;
+    }
+    this->mFrame = Frame;
+    if(Length > TRICK_MAX_FRAME_SIZE){
+        WARNING("Frame %d of %d bytes is too large for trick play", Frame, Length);
+        Length = TRICK_MAX_FRAME_SIZE;
+    }
+    // The frame is read behind the space for the PAT and PMT and filtered in place
+    uchar* Data = this->mBuffer + sizeof(this->mPatPmt);
+    off_t Offset = this->mFile->offsetOf(FileNumber, FileOffset);
+    if(Offset < 0 || !this->mFile->seek(Offset)){
+        ERROR("Frame %d is out of the recording", Frame);
+        return false;
+    }
+    int Bytes = this->mFile->read((char*)Data, Length - Length % TS_SIZE);
+    if(Bytes <= 0){
+        return false;
+    }
+    this->mLength = 0;
+    this->mOffset = 0;
+    for(int i = 0; i < this->mPatPmtPackets; i++){
+        this->appendPacket(this->mPatPmt + i * TS_SIZE);
+    }
+    for(int i = 0; i + TS_SIZE <= Bytes; i += TS_SIZE){
+        if(Data[i] == TS_SYNC_BYTE && TsPid(Data + i) == this->mVpid){
+            this->appendPacket(Data + i);
+        }
+    }
+    return true;
+}
+
+void cTrickPlayer::open(UpnpOpenFileMode){
+    MESSAGE(VERBOSE_RECORDS, "Trick player opened");
+}
+
+int cTrickPlayer::read(char* buf, size_t buflen){
+    size_t Done = 0;
+    while(Done < buflen){
+        if(this->mOffset == this->mLength && !this->loadFrame()){
+            break;
+        }
+        int Bytes = min((int)(buflen - Done), this->mLength - this->mOffset);
+        memcpy(buf + Done, this->mBuffer + this->mOffset, Bytes);
+        this->mOffset += Bytes;
+        Done += Bytes;
+    }
+    this->mPosition += Done;
+    return (int)Done;
+}
+
+int cTrickPlayer::write(char*, size_t){
+    ERROR("Writing not allowed on recordings");
+    return 0;
+}
+
+int cTrickPlayer::seek(off_t offset, int origin){
+    // Only the current position may be requested
+    off_t Position = origin == SEEK_CUR ? this->mPosition + offset : origin == SEEK_SET ? offset : -1;
+    if(Position != this->mPosition){
+        ERROR("Seeking not supported in trick play");
+        return -1;
+    }
+    return 0;
+}
+
+void cTrickPlayer::close(){
+    this->mFile->close();
+}
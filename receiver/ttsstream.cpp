@@ -0,0 +1,142 @@
+/*
+ * File:   ttsstream.cpp
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#include <vdr/tools.h>
+#include "ttsstream.h"
+
+#define PCR_WRAP        (((uint64_t)1 << 33) * 300)    // the PCR base has 33 bits
+
+cTimestampedStream::cTimestampedStream(cFileHandle* Stream) : mStream(Stream) {
+    this->mPartial = 0;
+    this->mLength = 0;
+    this->mOffset = 0;
+    this->mSkip = 0;
+    this->mPosition = 0;
+    this->mPcrPid = -1;
+    this->mLastPcr = 0;
+    this->mTicksPerPacket = 0;
+    this->mSincePcr = 0;
+}
+
+cTimestampedStream::~cTimestampedStream(){
+    delete this->mStream;
+}
+
+off_t cTimestampedStream::lengthOf(off_t Length){
+    return Length < 0 ? -1 : Length / TS_SIZE * TTS_SIZE;
+}
+
+void cTimestampedStream::open(UpnpOpenFileMode mode){
+    this->mStream->open(mode);
+}
+
+uint64_t cTimestampedStream::timestamp(const uchar* Packet){
+    bool HasPcr = TsHasAdaptationField(Packet) && Packet[4] >= 7 && (Packet[5] & 0x10);
+    if(HasPcr && (this->mPcrPid < 0 || this->mPcrPid == TsPid(Packet))){
+        uint64_t Base = ((uint64_t)Packet[6] << 25) | (Packet[7] << 17) | (Packet[8] << 9) | (Packet[9] << 1) | (Packet[10] >> 7);
+        uint64_t Pcr = Base * 300 + (((Packet[10] & 0x01) << 8) | Packet[11]);
+        if(this->mPcrPid >= 0 && this->mSincePcr > 0){
+            uint64_t Ticks = (Pcr + PCR_WRAP - this->mLastPcr) % PCR_WRAP;
+            // Discontinuities, e.g. after a seek, keep the last rate
+            if(Ticks < TTS_MAX_PCR_INTERVAL){
+                this->mTicksPerPacket = Ticks / this->mSincePcr;
+            }
+        }
+        this->mPcrPid = TsPid(Packet);
+        this->mLastPcr = Pcr;
+        this->mSincePcr = 0;
+        return Pcr;
+    }
+    return this->mLastPcr + ++this->mSincePcr * this->mTicksPerPacket;
+}
+
+int cTimestampedStream::fill(){
+    int Packets = 0;
+    while(!Packets){
+        int Bytes = this->mStream->read((char*)this->mPackets + this->mPartial, sizeof(this->mPackets) - this->mPartial);
+        if(Bytes <= 0){
+            return Bytes;
+        }
+        Bytes += this->mPartial;
+        Packets = Bytes / TS_SIZE;
+        for(int i = 0; i < Packets; i++){
+            const uchar* Packet = this->mPackets + i * TS_SIZE;
+            uchar* Dest = this->mOutput + i * TTS_SIZE;
+            // The copy permission indicator is 0, the time stamp has 30 bits
+            uint32_t Stamp = (uint32_t)(this->timestamp(Packet) & 0x3FFFFFFF);
+            Dest[0] = Stamp >> 24;
+            Dest[1] = Stamp >> 16;
+            Dest[2] = Stamp >> 8;
+            Dest[3] = Stamp;
+            memcpy(Dest + 4, Packet, TS_SIZE);
+        }
+        // Keep the beginning of an incomplete packet for the next read
+        this->mPartial = Bytes % TS_SIZE;
+        memmove(this->mPackets, this->mPackets + Packets * TS_SIZE, this->mPartial);
+    }
+    this->mLength = Packets * TTS_SIZE;
+    this->mOffset = min(this->mSkip, this->mLength);
+    this->mSkip = 0;
+    return this->mLength;
+}
+
+int cTimestampedStream::read(char* buf, size_t buflen){
+    size_t Done = 0;
+    while(Done < buflen){
+        if(this->mOffset == this->mLength){
+            int Result = this->fill();
+            if(Result < 0 && !Done){
+                return Result;
+            }
+            if(Result <= 0){
+                break;
+            }
+        }
+        int Bytes = min((int)(buflen - Done), this->mLength - this->mOffset);
+        memcpy(buf + Done, this->mOutput + this->mOffset, Bytes);
+        this->mOffset += Bytes;
+        Done += Bytes;
+    }
+    this->mPosition += Done;
+    return (int)Done;
+}
+
+int cTimestampedStream::write(char*, size_t){
+    ERROR("Writing not allowed on timestamped streams");
+    return 0;
+}
+
+int cTimestampedStream::seek(off_t offset, int origin){
+    off_t Position;
+    switch(origin){
+        case SEEK_SET:
+            Position = offset;
+            break;
+        case SEEK_CUR:
+            Position = this->mPosition + offset;
+            break;
+        default:
+            ERROR("Seeking from the end of a timestamped stream is not supported");
+            return -1;
+    }
+    if(Position < 0 || this->mStream->seek(Position / TTS_SIZE * TS_SIZE, SEEK_SET) < 0){
+        return -1;
+    }
+    // The first packet is read completely, its beginning is skipped
+    this->mSkip = Position % TTS_SIZE;
+    this->mPosition = Position;
+    this->mPartial = 0;
+    this->mLength = 0;
+    this->mOffset = 0;
+    this->mPcrPid = -1;
+    this->mSincePcr = 0;
+    return 0;
+}
+
+void cTimestampedStream::close(){
+    this->mStream->close();
+}
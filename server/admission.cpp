@@ -0,0 +1,106 @@
+/*
+ * File:   admission.cpp
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#include <vdr/tools.h>
+#include "admission.h"
+#include "config.h"
+
+cAdmissionControl* cAdmissionControl::mInstance = NULL;
+
+cAdmissionControl::cAdmissionControl(){
+    this->mStreams = 0;
+    this->mRejects = 0;
+    for(int i = 0; i <= UPNP_RESOURCE_URL; i++){
+        this->mTypes[i] = 0;
+    }
+}
+
+cAdmissionControl* cAdmissionControl::getInstance(){
+    if(cAdmissionControl::mInstance == NULL)
+        cAdmissionControl::mInstance = new cAdmissionControl();
+
+    return cAdmissionControl::mInstance;
+}
+
+bool cAdmissionControl::isAdmissible(unsigned int ResourceID, int ResourceType){
+    cUPnPConfig* Config = cUPnPConfig::get();
+    // The slots of the higher priorities are reserved
+    int Reserve;
+    switch(ResourceType){
+        case UPNP_RESOURCE_CHANNEL:
+            Reserve = 0;
+            break;
+        case UPNP_RESOURCE_RECORDING:
+            Reserve = STREAM_RESERVE;
+            break;
+        default:
+            Reserve = 2 * STREAM_RESERVE;
+    }
+    int Limit = max(1, Config->mMaxStreams - Reserve);
+    if(this->mStreams >= Limit){
+        WARNING("Rejecting a stream of resource #%d, %d of %d streams are open", ResourceID, this->mStreams, Limit);
+        return false;
+    }
+    // The clients of a channel share its receiver, so they are not limited per resource
+    if(ResourceType == UPNP_RESOURCE_CHANNEL){
+        return true;
+    }
+    std::map<unsigned int, int>::iterator It = this->mResources.find(ResourceID);
+    if(It != this->mResources.end() && It->second >= Config->mMaxStreamsPerResource){
+        WARNING("Rejecting a stream of resource #%d, which has %d streams", ResourceID, It->second);
+        return false;
+    }
+    return true;
+}
+
+bool cAdmissionControl::check(unsigned int ResourceID, int ResourceType){
+    cMutexLock MutexLock(&this->mMutex);
+    // The rejection is counted by admit(), so a request is not counted twice
+    return this->isAdmissible(ResourceID, ResourceType);
+}
+
+bool cAdmissionControl::admit(unsigned int ResourceID, int ResourceType){
+    cMutexLock MutexLock(&this->mMutex);
+    if(!this->isAdmissible(ResourceID, ResourceType)){
+        this->mRejects++;
+        return false;
+    }
+    this->mResources[ResourceID]++;
+    if(ResourceType >= 0 && ResourceType <= UPNP_RESOURCE_URL){
+        this->mTypes[ResourceType]++;
+    }
+    this->mStreams++;
+    MESSAGE(VERBOSE_WEBSERVER, "Admitted a stream of resource #%d, %d streams open, %d live", ResourceID, this->mStreams, this->mTypes[UPNP_RESOURCE_CHANNEL]);
+    return true;
+}
+
+void cAdmissionControl::release(unsigned int ResourceID, int ResourceType){
+    cMutexLock MutexLock(&this->mMutex);
+    std::map<unsigned int, int>::iterator It = this->mResources.find(ResourceID);
+    if(It == this->mResources.end()){
+        ERROR("Releasing a stream of resource #%d, which has none", ResourceID);
+        return;
+    }
+    if(--It->second == 0){
+        this->mResources.erase(It);
+    }
+    if(ResourceType >= 0 && ResourceType <= UPNP_RESOURCE_URL){
+        this->mTypes[ResourceType]--;
+    }
+    this->mStreams--;
+    MESSAGE(VERBOSE_WEBSERVER, "Released a stream of resource #%d, %d streams open, %d live", ResourceID, this->mStreams, this->mTypes[UPNP_RESOURCE_CHANNEL]);
+}
+
+int cAdmissionControl::getStreams(){
+    cMutexLock MutexLock(&this->mMutex);
+    return this->mStreams;
+}
+
+int cAdmissionControl::getStreams(int ResourceType){
+    cMutexLock MutexLock(&this->mMutex);
+    return (ResourceType >= 0 && ResourceType <= UPNP_RESOURCE_URL) ? this->mTypes[ResourceType] : 0;
+}
@@ -0,0 +1,349 @@
+/*
+ * File:   metrics.cpp
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#include <stdarg.h>
+#include <time.h>
+#include <vector>
+#include <vdr/tools.h>
+#include "metrics.h"
+#include "admission.h"
+#include "livereceiver.h"
+#include "segmentedfile.h"
+#include "pacer.h"
+#include "resources.h"
+
+// The upper bounds of the buckets in microseconds
+static const uint64_t HistogramBounds[METRICS_BUCKETS] = {
+    100, 500, 1000, 5000, 10000, 50000, 100000, 500000, 1000000, 5000000
+};
+
+static const char* ResourceTypes[UPNP_RESOURCE_URL + 1] = {
+    "channel", "recording", "file", "url"
+};
+
+static void append(std::string &Text, const char* Format, ...) __attribute__ ((format (printf, 2, 3)));
+
+static void append(std::string &Text, const char* Format, ...){
+    char Line[512];
+    va_list Arguments;
+    va_start(Arguments, Format);
+    vsnprintf(Line, sizeof(Line), Format, Arguments);
+    va_end(Arguments);
+    Text += Line;
+}
+
+static void describe(std::string &Text, const char* Name, const char* Type, const char* Help){
+    append(Text, "# HELP %s %s\n# TYPE %s %s\n", Name, Help, Name, Type);
+}
+
+cHistogram::cHistogram(){
+    for(int i = 0; i < METRICS_BUCKETS; i++){
+        this->mBuckets[i] = 0;
+    }
+    this->mCount = 0;
+    this->mSum = 0;
+}
+
+void cHistogram::observe(uint64_t Microseconds){
+    for(int i = 0; i < METRICS_BUCKETS; i++){
+        if(Microseconds <= HistogramBounds[i]){
+            this->mBuckets[i]++;
+            break;
+        }
+    }
+    this->mCount++;
+    this->mSum += Microseconds;
+}
+
+void cHistogram::format(std::string &Text, const char* Name, const char* Labels) const {
+    const char* Separator = *Labels ? "," : "";
+    long Count = 0;
+    for(int i = 0; i < METRICS_BUCKETS; i++){
+        Count += this->mBuckets[i];
+        append(Text, "%s_bucket{%s%sle=\"%g\"} %ld\n", Name, Labels, Separator, HistogramBounds[i] / 1000000.0, Count);
+    }
+    append(Text, "%s_bucket{%s%sle=\"+Inf\"} %ld\n", Name, Labels, Separator, this->mCount);
+    append(Text, "%s_sum{%s} %.6f\n", Name, Labels, this->mSum / 1000000.0);
+    append(Text, "%s_count{%s} %ld\n", Name, Labels, this->mCount);
+}
+
+cMetrics* cMetrics::mInstance = NULL;
+
+cMetrics::cMetrics(){
+    for(int i = 0; i <= UPNP_RESOURCE_URL; i++){
+        this->mBytes[i] = 0;
+        this->mReadErrors[i] = 0;
+    }
+    this->mNextStream = 1;
+}
+
+cMetrics* cMetrics::getInstance(){
+    if(cMetrics::mInstance == NULL)
+        cMetrics::mInstance = new cMetrics();
+
+    return cMetrics::mInstance;
+}
+
+uint64_t cMetrics::now(){
+    struct timespec Now;
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    return (uint64_t)Now.tv_sec * 1000000 + Now.tv_nsec / 1000;
+}
+
+int cMetrics::openStream(unsigned int ResourceID, int ResourceType, cFileHandle* FileHandle){
+    cMutexLock MutexLock(&this->mMutex);
+    int Stream = this->mNextStream++;
+    cStreamMetrics &Metrics = this->mStreams[Stream];
+    Metrics.ResourceID = ResourceID;
+    Metrics.ResourceType = ResourceType;
+    Metrics.FileHandle = FileHandle;
+    Metrics.Bytes = 0;
+    Metrics.ReadErrors = 0;
+    return Stream;
+}
+
+void cMetrics::closeStream(int Stream){
+    cMutexLock MutexLock(&this->mMutex);
+    this->mStreams.erase(Stream);
+}
+
+void cMetrics::observeRead(int Stream, int ResourceType, int Bytes, uint64_t Microseconds){
+    if(ResourceType < 0 || ResourceType > UPNP_RESOURCE_URL){
+        return;
+    }
+    cMutexLock MutexLock(&this->mMutex);
+    this->mReads[ResourceType].observe(Microseconds);
+    if(Bytes < 0){
+        this->mReadErrors[ResourceType]++;
+    }
+    else {
+        this->mBytes[ResourceType] += Bytes;
+    }
+    std::map<int, cStreamMetrics>::iterator It = this->mStreams.find(Stream);
+    if(It != this->mStreams.end()){
+        It->second.Reads.observe(Microseconds);
+        if(Bytes < 0){
+            It->second.ReadErrors++;
+        }
+        else {
+            It->second.Bytes += Bytes;
+        }
+    }
+}
+
+void cMetrics::observeAction(const char* Action, bool Failed, uint64_t Microseconds){
+    cMutexLock MutexLock(&this->mMutex);
+    this->mActions[Action].observe(Microseconds);
+    if(Failed){
+        this->mActionErrors[Action]++;
+    }
+}
+
+void cMetrics::observeStatement(const char* Statement, uint64_t Microseconds){
+    // The statements are told apart by their first keyword only
+    const char* Keywords[] = { "SELECT", "INSERT", "UPDATE", "DELETE", "BEGIN", "COMMIT", "ROLLBACK", "CREATE", NULL };
+    const char* Kind = "other";
+    Statement = skipspace(Statement);
+    for(int i = 0; Keywords[i]; i++){
+        if(!strncasecmp(Statement, Keywords[i], strlen(Keywords[i]))){
+            Kind = Keywords[i];
+            break;
+        }
+    }
+    cMutexLock MutexLock(&this->mMutex);
+    this->mStatements[Kind].observe(Microseconds);
+}
+
+std::string cMetrics::getText(){
+    std::string Text;
+    char Labels[128];
+
+    cAdmissionControl* Admission = cAdmissionControl::getInstance();
+    describe(Text, "upnp_streams", "gauge", "Open streams by resource type");
+    for(int i = 0; i <= UPNP_RESOURCE_URL; i++){
+        append(Text, "upnp_streams{type=\"%s\"} %d\n", ResourceTypes[i], Admission->getStreams(i));
+    }
+    describe(Text, "upnp_stream_rejects_total", "counter", "Streams rejected by the admission control");
+    append(Text, "upnp_stream_rejects_total %ld\n", Admission->getRejects());
+
+    this->mMutex.Lock();
+    describe(Text, "upnp_stream_bytes_total", "counter", "Bytes served by resource type");
+    for(int i = 0; i <= UPNP_RESOURCE_URL; i++){
+        append(Text, "upnp_stream_bytes_total{type=\"%s\"} %llu\n", ResourceTypes[i], (unsigned long long)this->mBytes[i]);
+    }
+    describe(Text, "upnp_stream_read_errors_total", "counter", "Failed reads by resource type");
+    for(int i = 0; i <= UPNP_RESOURCE_URL; i++){
+        append(Text, "upnp_stream_read_errors_total{type=\"%s\"} %ld\n", ResourceTypes[i], this->mReadErrors[i]);
+    }
+    describe(Text, "upnp_stream_read_seconds", "histogram", "Duration of the reads of the streams by resource type");
+    for(int i = 0; i <= UPNP_RESOURCE_URL; i++){
+        snprintf(Labels, sizeof(Labels), "type=\"%s\"", ResourceTypes[i]);
+        this->mReads[i].format(Text, "upnp_stream_read_seconds", Labels);
+    }
+    // A stream keeps its file handle, until it is removed from the map
+    describe(Text, "upnp_stream_handle_bytes_total", "counter", "Bytes served by an open stream");
+    for(std::map<int, cStreamMetrics>::iterator It = this->mStreams.begin(); It != this->mStreams.end(); It++){
+        append(Text, "upnp_stream_handle_bytes_total{type=\"%s\",resource=\"%u\",stream=\"%d\"} %llu\n", ResourceTypes[It->second.ResourceType],
+               It->second.ResourceID, It->first, (unsigned long long)It->second.Bytes);
+    }
+    describe(Text, "upnp_stream_handle_read_errors_total", "counter", "Failed reads of an open stream");
+    for(std::map<int, cStreamMetrics>::iterator It = this->mStreams.begin(); It != this->mStreams.end(); It++){
+        append(Text, "upnp_stream_handle_read_errors_total{type=\"%s\",resource=\"%u\",stream=\"%d\"} %ld\n", ResourceTypes[It->second.ResourceType],
+               It->second.ResourceID, It->first, It->second.ReadErrors);
+    }
+    describe(Text, "upnp_stream_handle_read_seconds", "histogram", "Duration of the reads of an open stream");
+    for(std::map<int, cStreamMetrics>::iterator It = this->mStreams.begin(); It != this->mStreams.end(); It++){
+        snprintf(Labels, sizeof(Labels), "type=\"%s\",resource=\"%u\",stream=\"%d\"", ResourceTypes[It->second.ResourceType],
+                 It->second.ResourceID, It->first);
+        It->second.Reads.format(Text, "upnp_stream_handle_read_seconds", Labels);
+    }
+    describe(Text, "upnp_stream_handle_stalls_total", "counter", "Reads of an open stream which took longer than the stall threshold");
+    for(std::map<int, cStreamMetrics>::iterator It = this->mStreams.begin(); It != this->mStreams.end(); It++){
+        append(Text, "upnp_stream_handle_stalls_total{type=\"%s\",resource=\"%u\",stream=\"%d\"} %ld\n", ResourceTypes[It->second.ResourceType],
+               It->second.ResourceID, It->first, It->second.FileHandle->getStalls());
+    }
+    describe(Text, "upnp_stream_handle_stall_seconds_total", "counter", "Time the stalled reads of an open stream took");
+    for(std::map<int, cStreamMetrics>::iterator It = this->mStreams.begin(); It != this->mStreams.end(); It++){
+        append(Text, "upnp_stream_handle_stall_seconds_total{type=\"%s\",resource=\"%u\",stream=\"%d\"} %.3f\n", ResourceTypes[It->second.ResourceType],
+               It->second.ResourceID, It->first, It->second.FileHandle->getStallTime() / 1000.0);
+    }
+    describe(Text, "upnp_soap_action_seconds", "histogram", "Duration of the actions of the content directory");
+    for(std::map<std::string, cHistogram>::iterator It = this->mActions.begin(); It != this->mActions.end(); It++){
+        snprintf(Labels, sizeof(Labels), "action=\"%s\"", It->first.c_str());
+        It->second.format(Text, "upnp_soap_action_seconds", Labels);
+    }
+    describe(Text, "upnp_soap_action_errors_total", "counter", "Failed actions of the content directory");
+    for(std::map<std::string, long>::iterator It = this->mActionErrors.begin(); It != this->mActionErrors.end(); It++){
+        append(Text, "upnp_soap_action_errors_total{action=\"%s\"} %ld\n", It->first.c_str(), It->second);
+    }
+    describe(Text, "upnp_sqlite_statement_seconds", "histogram", "Duration of the SQLite statements by their first keyword");
+    for(std::map<std::string, cHistogram>::iterator It = this->mStatements.begin(); It != this->mStatements.end(); It++){
+        snprintf(Labels, sizeof(Labels), "statement=\"%s\"", It->first.c_str());
+        It->second.format(Text, "upnp_sqlite_statement_seconds", Labels);
+    }
+    this->mMutex.Unlock();
+
+    cResourceCache* Cache = cUPnPResources::getInstance()->getCache();
+    describe(Text, "upnp_resource_cache_entries", "gauge", "Resources in the resource cache");
+    append(Text, "upnp_resource_cache_entries %d\n", Cache->getCount());
+    describe(Text, "upnp_resource_cache_hits_total", "counter", "Resource lookups answered by the cache");
+    append(Text, "upnp_resource_cache_hits_total %ld\n", Cache->getHits());
+    describe(Text, "upnp_resource_cache_misses_total", "counter", "Resource lookups which loaded the resource from the database");
+    append(Text, "upnp_resource_cache_misses_total %ld\n", Cache->getMisses());
+    describe(Text, "upnp_resource_cache_evictions_total", "counter", "Resources of EPG items evicted from the cache");
+    append(Text, "upnp_resource_cache_evictions_total %ld\n", Cache->getEvictions());
+
+    cLiveReceivers* Receivers = cLiveReceivers::getInstance();
+    std::vector<cLiveReceiverStatus> Status;
+    Receivers->getStatus(Status);
+    describe(Text, "upnp_live_receivers", "gauge", "Attached live receivers");
+    append(Text, "upnp_live_receivers %d\n", (int)Status.size());
+    describe(Text, "upnp_live_pool_hits_total", "counter", "Live streams served by an idle receiver");
+    append(Text, "upnp_live_pool_hits_total %ld\n", Receivers->getHits());
+    describe(Text, "upnp_live_pool_misses_total", "counter", "Live streams for which a device was tuned");
+    append(Text, "upnp_live_pool_misses_total %ld\n", Receivers->getMisses());
+    describe(Text, "upnp_live_failovers_total", "counter", "Live receivers attached to another device");
+    append(Text, "upnp_live_failovers_total %ld\n", Receivers->getFailovers());
+    describe(Text, "upnp_live_failed_failovers_total", "counter", "Live receivers given up without another device");
+    append(Text, "upnp_live_failed_failovers_total %ld\n", Receivers->getFailedFailovers());
+    describe(Text, "upnp_live_clients", "gauge", "Streams of a live receiver");
+    for(size_t i = 0; i < Status.size(); i++){
+        append(Text, "upnp_live_clients{channel=\"%s\"} %d\n", *Status[i].ChannelID.ToString(), Status[i].Clients);
+    }
+    describe(Text, "upnp_live_bitrate_bits", "gauge", "Measured bitrate of a live receiver in bit/s");
+    for(size_t i = 0; i < Status.size(); i++){
+        append(Text, "upnp_live_bitrate_bits{channel=\"%s\"} %lld\n", *Status[i].ChannelID.ToString(), Status[i].Bitrate * 1000LL);
+    }
+    describe(Text, "upnp_live_buffer_bytes", "gauge", "Size of the live buffer");
+    for(size_t i = 0; i < Status.size(); i++){
+        append(Text, "upnp_live_buffer_bytes{channel=\"%s\"} %d\n", *Status[i].ChannelID.ToString(), Status[i].BufferSize);
+    }
+    describe(Text, "upnp_live_buffer_fill_ratio", "gauge", "Fill level of the live buffer with packets not analyzed yet");
+    for(size_t i = 0; i < Status.size(); i++){
+        append(Text, "upnp_live_buffer_fill_ratio{channel=\"%s\"} %.2f\n", *Status[i].ChannelID.ToString(), Status[i].Fill / 100.0);
+    }
+    describe(Text, "upnp_live_buffer_peak_fill_ratio", "gauge", "Highest fill level of the live buffer");
+    for(size_t i = 0; i < Status.size(); i++){
+        append(Text, "upnp_live_buffer_peak_fill_ratio{channel=\"%s\"} %.2f\n", *Status[i].ChannelID.ToString(), Status[i].PeakFill / 100.0);
+    }
+    describe(Text, "upnp_live_overflows_total", "counter", "Times the receiver thread fell behind and data was lost");
+    for(size_t i = 0; i < Status.size(); i++){
+        append(Text, "upnp_live_overflows_total{channel=\"%s\"} %d\n", *Status[i].ChannelID.ToString(), Status[i].Overflows);
+    }
+    describe(Text, "upnp_live_overruns_total", "counter", "Times a stream was overrun by the receiver");
+    for(size_t i = 0; i < Status.size(); i++){
+        append(Text, "upnp_live_overruns_total{channel=\"%s\"} %d\n", *Status[i].ChannelID.ToString(), Status[i].Overruns);
+    }
+
+    cSegmentTables* Tables = cSegmentTables::getInstance();
+    describe(Text, "upnp_segment_table_hits_total", "counter", "Recordings opened without a scan");
+    append(Text, "upnp_segment_table_hits_total %ld\n", Tables->getHits());
+    describe(Text, "upnp_segment_table_misses_total", "counter", "Recordings which had to be scanned");
+    append(Text, "upnp_segment_table_misses_total %ld\n", Tables->getMisses());
+    describe(Text, "upnp_recording_stalls_total", "counter", "Reads of recordings which took longer than the stall threshold");
+    append(Text, "upnp_recording_stalls_total %ld\n", Tables->getStalls());
+    describe(Text, "upnp_recording_stall_seconds_total", "counter", "Time the stalled reads of recordings took");
+    append(Text, "upnp_recording_stall_seconds_total %.3f\n", Tables->getStallTime() / 1000.0);
+
+    cStreamScheduler* Scheduler = cStreamScheduler::getInstance();
+    describe(Text, "upnp_paced_streams", "gauge", "Streams limited by a token bucket");
+    append(Text, "upnp_paced_streams %d\n", Scheduler->getStreams());
+    describe(Text, "upnp_pacing_fairness", "gauge", "Fairness index of the paced streams");
+    append(Text, "upnp_pacing_fairness %.3f\n", Scheduler->getFairness());
+    describe(Text, "upnp_pacing_throttles_total", "counter", "Reads which waited for tokens");
+    append(Text, "upnp_pacing_throttles_total %ld\n", Scheduler->getThrottles());
+    describe(Text, "upnp_pacing_throttle_seconds_total", "counter", "Time reads waited for tokens");
+    append(Text, "upnp_pacing_throttle_seconds_total %.3f\n", Scheduler->getThrottleTime() / 1000.0);
+    return Text;
+}
+
+cMetricsFile::cMetricsFile(){
+    this->mPosition = 0;
+}
+
+cMetricsFile::~cMetricsFile(){}
+
+void cMetricsFile::open(UpnpOpenFileMode){
+    this->mText = cMetrics::getInstance()->getText();
+    this->mPosition = 0;
+}
+
+int cMetricsFile::read(char* buf, size_t buflen){
+    size_t Bytes = min(buflen, this->mText.size() - this->mPosition);
+    memcpy(buf, this->mText.data() + this->mPosition, Bytes);
+    this->mPosition += Bytes;
+    return (int)Bytes;
+}
+
+int cMetricsFile::write(char*, size_t){
+    ERROR("Writing not allowed on the metrics");
+    return 0;
+}
+
+int cMetricsFile::seek(off_t offset, int origin){
+    off_t Position;
+    switch(origin){
+        case SEEK_SET:
+            Position = offset;
+            break;
+        case SEEK_CUR:
+            Position = this->mPosition + offset;
+            break;
+        case SEEK_END:
+            Position = this->mText.size() + offset;
+            break;
+        default:
+            return -1;
+    }
+    if(Position < 0 || Position > (off_t)this->mText.size()){
+        return -1;
+    }
+    this->mPosition = Position;
+    return 0;
+}
+
+void cMetricsFile::close(){}
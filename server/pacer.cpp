@@ -0,0 +1,109 @@
+/*
+ * File:   pacer.cpp
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+#include <algorithm>
+#include <vdr/tools.h>
+#include "pacer.h"
+#include "config.h"
+
+cTokenBucket::cTokenBucket(double Rate){
+    this->mRate = Rate;
+    this->mCapacity = Rate * STREAM_PACING_BURST;
+    this->mTokens = this->mCapacity;
+    this->mLast = cTimeMs::Now();
+    this->mStarted = this->mLast;
+    this->mBytes = 0;
+}
+
+void cTokenBucket::refill(){
+    uint64_t Now = cTimeMs::Now();
+    this->mTokens = min(this->mCapacity, this->mTokens + this->mRate * (Now - this->mLast) / 1000);
+    this->mLast = Now;
+}
+
+void cTokenBucket::take(size_t Bytes){
+    this->refill();
+    if(this->mTokens < Bytes){
+        // Wait until the missing tokens were added
+        int Wait = (int)((Bytes - this->mTokens) * 1000 / this->mRate) + 1;
+        MESSAGE(VERBOSE_BUFFERS, "Pacing stream for %d ms", Wait);
+        cCondWait::SleepMs(Wait);
+        cStreamScheduler::getInstance()->throttled(Wait);
+        this->refill();
+    }
+    // The bucket may be overdrawn by a single read larger than the bucket
+    this->mTokens -= Bytes;
+    this->mBytes += Bytes;
+}
+
+void cTokenBucket::burst(){
+    this->mTokens = this->mCapacity;
+    this->mLast = cTimeMs::Now();
+}
+
+double cTokenBucket::getShare() const {
+    uint64_t Elapsed = cTimeMs::Now() - this->mStarted;
+    return Elapsed ? this->mBytes * 1000.0 / Elapsed / this->mRate : 0;
+}
+
+cStreamScheduler* cStreamScheduler::mInstance = NULL;
+
+cStreamScheduler::cStreamScheduler(){
+    this->mThrottles = 0;
+    this->mThrottleTime = 0;
+}
+
+cStreamScheduler* cStreamScheduler::getInstance(){
+    if(cStreamScheduler::mInstance == NULL)
+        cStreamScheduler::mInstance = new cStreamScheduler();
+
+    return cStreamScheduler::mInstance;
+}
+
+cTokenBucket* cStreamScheduler::attach(double Rate){
+    int Pacing = cUPnPConfig::get()->mPacing;
+    if(Pacing <= 0 || Rate <= 0){
+        return NULL;
+    }
+    cTokenBucket* Bucket = new cTokenBucket(Rate * Pacing / 100);
+    cMutexLock MutexLock(&this->mMutex);
+    this->mBuckets.push_back(Bucket);
+    MESSAGE(VERBOSE_WEBSERVER, "Pacing stream at %.0f KB/s, %d streams paced", Bucket->getRate() / 1024, (int)this->mBuckets.size());
+    return Bucket;
+}
+
+void cStreamScheduler::detach(cTokenBucket* Bucket){
+    if(!Bucket){
+        return;
+    }
+    cMutexLock MutexLock(&this->mMutex);
+    this->mBuckets.erase(std::remove(this->mBuckets.begin(), this->mBuckets.end(), Bucket), this->mBuckets.end());
+    delete Bucket;
+}
+
+double cStreamScheduler::getFairness(){
+    cMutexLock MutexLock(&this->mMutex);
+    // (sum x)^2 / (n * sum x^2)
+    double Sum = 0, Squares = 0;
+    for(std::vector<cTokenBucket*>::iterator It = this->mBuckets.begin(); It != this->mBuckets.end(); It++){
+        double Share = (*It)->getShare();
+        Sum += Share;
+        Squares += Share * Share;
+    }
+    return Squares > 0 ? Sum * Sum / (this->mBuckets.size() * Squares) : 1;
+}
+
+int cStreamScheduler::getStreams(){
+    cMutexLock MutexLock(&this->mMutex);
+    return (int)this->mBuckets.size();
+}
+
+void cStreamScheduler::throttled(uint64_t Time){
+    cMutexLock MutexLock(&this->mMutex);
+    this->mThrottles++;
+    this->mThrottleTime += Time;
+}
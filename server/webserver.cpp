@@ -3,7 +3,7 @@
  * Author: savop
  * Author: J.Huber, IRT GmbH
  * Created on 30. Mai 2009, 18:13
- * Last modification: April 9, 2013
+ * Last modification: October 17, 2026
  */
 
 #include <time.h>
@@ -13,10 +13,16 @@
 #include <upnp/upnp.h>
 #include "webserver.h"
 #include "server.h"
-#include "livereceiver.h"
+#include "livestream.h"
 #include "recplayer.h"
+#include "trickplayer.h"
+#include "pacer.h"
+#include "admission.h"
+#include "metrics.h"
+#include "ttsstream.h"
 #include "fileplayer.h"
 #include "search.h"
+#include "upnp/dlna.h"
 #include "vdrepg.h"
 
 /* COPIED FROM INTEL UPNP TOOLS */
@@ -83,6 +89,10 @@ struct cWebFileHandle {
     cString      Filename;
     off64_t      Size;
     cFileHandle* FileHandle;
+    cTokenBucket* Bucket;
+    unsigned int ResourceID;
+    int          ResourceType;
+    int          Stream;
 };
 
 /****************************************************
@@ -142,12 +152,17 @@ bool cUPnPWebServer::init(){
         ERROR("The virtual directory %s is invalid.",UPNP_DIR_SHARES);
         return false;
     }
+    if(UpnpAddVirtualDir(UPNP_DIR_METRICS) == UPNP_E_INVALID_ARGUMENT){
+        ERROR("The virtual directory %s is invalid.",UPNP_DIR_METRICS);
+        return false;
+    }
     return true;
 }
 
 bool cUPnPWebServer::uninit(){
     MESSAGE(VERBOSE_WEBSERVER, "Disabling the internal webserver");
     UpnpEnableWebserver(FALSE);
+    cLiveReceivers::getInstance()->clear();
 
     return true;
 }
@@ -165,35 +180,115 @@ cUPnPWebServer* cUPnPWebServer::getInstance(const char* rootdir){
 int cUPnPWebServer::getInfo(const char* filename, File_Info* info){
     MESSAGE(VERBOSE_WEBSERVER, "Getting information of file '%s'", filename);
 
-    propertyMap Properties;
-    int Method;
-    int Section;
-
-    if(cPathParser::parse(filename, &Section, &Method, &Properties)){
-        switch(Section){
+    cWebPath Path;
+
+    if(!strcmp(filename, UPNP_DIR_METRICS)){
+        // The metrics are taken when the file is opened, so the length is unknown
+        File_Info_ finfo;
+        finfo.content_type = ixmlCloneDOMString(METRICS_CONTENT_TYPE);
+        finfo.file_length = -1;
+        finfo.is_directory = 0;
+        finfo.is_readable = 1;
+        finfo.last_modified = time(NULL);
+        memcpy(info, &finfo, sizeof(File_Info_));
+        return 0;
+    }
+    if(cPathParser::parseFast(filename, &Path)){
+        switch(Path.Section){
             case 0:
-                switch(Method){
+                switch(Path.Method){
                     case UPNP_WEB_METHOD_STREAM:
                         {
                             MESSAGE(VERBOSE_WEBSERVER, "Stream request, getInfo");
-                            propertyMap::iterator It = Properties.find("resId");
+                            const char* ResId = Path.get("resId");
                             unsigned int ResourceID = 0;
-                            if(It == Properties.end()){
+                            if(!ResId){
                                 ERROR("No resourceID for stream request");
                                 return -1;
                             }
                             else {
-                                ResourceID = (unsigned)atoi(It->second);
-                                cUPnPResource* Resource = cUPnPResources::getInstance()->getResource(ResourceID);
+                                ResourceID = (unsigned)atoi(ResId);
+                                cUPnPResourceRef Resource(ResourceID);
                                 if(!Resource){
                                     ERROR("No such resource with ID (%d)", ResourceID);
                                     return -1;
                                 }
+                                else if(!cAdmissionControl::getInstance()->check(ResourceID, Resource->getResourceType())){
+                                    // Reject the request before anything is tuned or read
+                                    return -1;
+                                }
                                 else {
                                     File_Info_ finfo;
+                                    // The features of a stream differ from the ones of the resource in a few cases only
+                                    unsigned int Flags = Resource->getDlnaFlags();
+                                    int Operation = Resource->getDlnaOperation();
+                                    bool Timestamped = false;
 
                                     finfo.content_type = ixmlCloneDOMString(Resource->getContentType());
                                     finfo.file_length = Resource->getFileSize();
+                                    if(Resource->getResourceType() == UPNP_RESOURCE_CHANNEL && cUPnPConfig::get()->mLiveTimeshift > 0){
+                                        // The resource is "<channel ID>:<stream ID>"
+                                        char* ChannelID = strdup(Resource->getResource());
+                                        char* Separator = strrchr(ChannelID, ':');
+                                        if(Separator) *Separator = 0;
+                                        uint64_t Start = 0, Length = 0;
+                                        if(cLiveReceivers::getInstance()->getTimeshiftWindow(tChannelID::FromString(ChannelID), Start, Length)){
+                                            // The length grows as long as the channel is received
+                                            finfo.file_length = (off_t)Length;
+                                            MESSAGE(VERBOSE_LIVE_TV, "Timeshift of channel %s from %llu to %llu", ChannelID,
+                                                    (unsigned long long)Start, (unsigned long long)Length);
+                                        }
+                                        free(ChannelID);
+                                    }
+                                    else if(Resource->getResourceType() == UPNP_RESOURCE_RECORDING){
+                                        cRecording* Recording = Recordings.GetByName(Resource->getResource());
+                                        if(Recording && cRecordingPlayer::isRecording(Recording)){
+                                            // The length is unknown until the timer has finished
+                                            finfo.file_length = -1;
+                                            Flags |= DLNA_FLAG_SN_INCREASE;
+                                        }
+                                        // A recording may be requested from a normal play time on
+                                        const char* Npt = Path.get("npt");
+                                        // or from an editing mark on
+                                        const char* Mark = Path.get("mark");
+                                        const char* Speed = Path.get("speed");
+                                        if(Speed){
+                                            // Trick play streams have no length and cannot be seeked
+                                            if(!cTrickPlayer::parseSpeed(Speed)){
+                                                ixmlFreeDOMString(finfo.content_type);
+                                                return -1;
+                                            }
+                                            Operation = DLNA_OPERATION_NONE;
+                                            finfo.file_length = -1;
+                                        }
+                                        else if(Npt || Mark){
+                                            cRecordingPlayer* Player = Recording ? cRecordingPlayer::newInstance(Recording) : NULL;
+                                            bool Started = Player && (Npt ? Player->setStartTime(Npt) : Player->setStartMark(Mark));
+                                            if(Started && finfo.file_length >= 0){
+                                                finfo.file_length = Player->getLength();
+                                            }
+                                            delete Player;
+                                            if(!Started){
+                                                ERROR("Cannot start resource #%d at %s", ResourceID, Npt ? Npt : Mark);
+                                                ixmlFreeDOMString(finfo.content_type);
+                                                return -1;
+                                            }
+                                        }
+                                    }
+                                    const char* Tts = Path.get("tts");
+                                    if(Tts && atoi(Tts)){
+                                        Timestamped = true;
+                                        // Every packet gets four bytes more
+                                        ixmlFreeDOMString(finfo.content_type);
+                                        finfo.content_type = ixmlCloneDOMString(TTS_CONTENT_TYPE);
+                                        finfo.file_length = cTimestampedStream::lengthOf(finfo.file_length);
+                                    }
+                                    const char* Features = Resource->getContentFeatures();
+                                    char Buffer[DLNA_MAX_PROTOCOL_INFO];
+                                    if(Timestamped || Operation != Resource->getDlnaOperation() || Flags != Resource->getDlnaFlags()){
+                                        // The profile of the resource does not fit a timestamped stream
+                                        Features = cDlna::getContentFeatures(Buffer, sizeof(Buffer), NULL, Operation, NULL, DLNA_CONVERSION_NONE, Flags);
+                                    }
                                     finfo.is_directory = 0;
                                     finfo.is_readable = 1;
                                     finfo.last_modified = Resource->getLastModification();
@@ -205,18 +300,16 @@ int cUPnPWebServer::getInfo(const char* filename, File_Info* info){
                                     MESSAGE(VERBOSE_METADATA, "Read: %s", finfo.is_readable?"allowed":"not allowed");
                                     MESSAGE(VERBOSE_METADATA, "Last modified: %s", ctime(&(finfo.last_modified)));
                                     MESSAGE(VERBOSE_METADATA, "Content-type: %s", finfo.content_type);
+                                    MESSAGE(VERBOSE_METADATA, "Content features: %s", Features);
 									MESSAGE(VERBOSE_METADATA, "Task %i %s", Resource->getRecordTimer(), (Resource->getRecordTimer() == DO_TRIGGER_TIMER) ?
 										"'Program_Record_Timer'" : (Resource->getRecordTimer() == PURGE_RECORD_TIMER) ?  "'Purge_Record_Timer'" : "None");
 									handleRecordTimer(Resource);
 
 #ifdef UPNP_HAVE_CUSTOMHEADERS
+                                    char Header[DLNA_MAX_PROTOCOL_INFO + 32];
                                     UpnpAddCustomHTTPHeader("transferMode.dlna.org: Streaming");
-                                    UpnpAddCustomHTTPHeader(
-                                        "contentFeatures.dlna.org: "
-                                        "DLNA.ORG_OP=00;"
-                                        "DLNA.ORG_CI=0;"
-                                        "DLNA.ORG_FLAGS=01700000000000000000000000000000"
-                                        );
+                                    snprintf(Header, sizeof(Header), "contentFeatures.dlna.org: %s", Features);
+                                    UpnpAddCustomHTTPHeader(Header);
 #endif
                                 }
                             }
@@ -229,12 +322,12 @@ int cUPnPWebServer::getInfo(const char* filename, File_Info* info){
                     case UPNP_WEB_METHOD_SEARCH:
                     case UPNP_WEB_METHOD_DOWNLOAD:
                     default:
-                        ERROR("Unknown or unsupported method ID (%d)", Method);
+                        ERROR("Unknown or unsupported method ID (%d)", Path.Method);
                         return -1;
                 }
                 break;
             default:
-                ERROR("Unknown or unsupported section ID (%d).", Section);
+                ERROR("Unknown or unsupported section ID (%d).", Path.Section);
                 return -1;
         }
     }
@@ -248,35 +341,55 @@ int cUPnPWebServer::getInfo(const char* filename, File_Info* info){
 UpnpWebFileHandle cUPnPWebServer::open(const char* filename, UpnpOpenFileMode mode){
     MESSAGE(VERBOSE_WEBSERVER, "File %s was opened for %s.",filename,mode==UPNP_READ ? "reading" : "writing");
 
-    propertyMap Properties;
-    int Method;
-    int Section;
+    cWebPath Path;
     cWebFileHandle* WebFileHandle = NULL;
 
-    if(cPathParser::parse(filename, &Section, &Method, &Properties)){
-        switch(Section){
+    if(!strcmp(filename, UPNP_DIR_METRICS)){
+        WebFileHandle = new cWebFileHandle;
+        WebFileHandle->Filename = filename;
+        WebFileHandle->Size = 0;
+        WebFileHandle->FileHandle = new cMetricsFile;
+        WebFileHandle->Bucket = NULL;
+        // The metrics are no stream and take no slot
+        WebFileHandle->ResourceID = 0;
+        WebFileHandle->ResourceType = -1;
+        WebFileHandle->Stream = 0;
+        WebFileHandle->FileHandle->open(mode);
+        return (UpnpWebFileHandle)WebFileHandle;
+    }
+    if(cPathParser::parseFast(filename, &Path)){
+        switch(Path.Section){
             case 0:
-                switch(Method){
+                switch(Path.Method){
                     case UPNP_WEB_METHOD_STREAM:
                         {
                             MESSAGE(VERBOSE_WEBSERVER, "Stream request, open");
-                            propertyMap::iterator It = Properties.find("resId");
+                            const char* ResId = Path.get("resId");
                             unsigned int ResourceID = 0;
-                            if(It == Properties.end()){
+                            if(!ResId){
                                 ERROR("No resourceID for stream request");
                                 return NULL;
                             }
                             else {
-                                ResourceID = (unsigned)atoi(It->second);
-                                cUPnPResource* Resource = cUPnPResources::getInstance()->getResource(ResourceID);
+                                ResourceID = (unsigned)atoi(ResId);
+                                cUPnPResourceRef Resource(ResourceID);
                                 if(!Resource){
                                     ERROR("No such resource with ID (%d)", ResourceID);
                                     return NULL;
                                 }
+                                else if(!cAdmissionControl::getInstance()->admit(ResourceID, Resource->getResourceType())){
+                                    return NULL;
+                                }
                                 else {
                                     WebFileHandle = new cWebFileHandle;
                                     WebFileHandle->Filename = Resource->getResource();
                                     WebFileHandle->Size = Resource->getFileSize();
+                                    WebFileHandle->FileHandle = NULL;
+                                    WebFileHandle->Bucket = NULL;
+                                    WebFileHandle->ResourceID = ResourceID;
+                                    WebFileHandle->ResourceType = Resource->getResourceType();
+                                    // The average rate of the stream in bytes per second
+                                    double Rate = Resource->getBitrate() / 8.0;
                                     switch(Resource->getResourceType()){
                                         case UPNP_RESOURCE_CHANNEL:
                                             {
@@ -286,14 +399,20 @@ UpnpWebFileHandle cUPnPWebServer::open(const char* filename, UpnpOpenFileMode mo
                                                 cChannel* Channel = Channels.GetByChannelID(tChannelID::FromString(ChannelID));
                                                 if(!Channel){
                                                     ERROR("No such channel with ID %s", ChannelID);
-                                                    return NULL;
+                                                    break;
                                                 }
-                                                cLiveReceiver* Receiver = cLiveReceiver::newInstance(Channel,0);
-                                                if(!Receiver){
+                                                cLiveStream* Stream = cLiveStream::newInstance(Channel,0);
+                                                if(!Stream){
                                                     ERROR("Unable to tune channel. No available tuners?");
-                                                    return NULL;
+                                                    break;
                                                 }
-                                                WebFileHandle->FileHandle = Receiver;
+                                                // Clients may select audio tracks by PID or by language
+                                                const char* Audio = Path.get("apid");
+                                                if(!Audio) Audio = Path.get("audio");
+                                                if(Audio){
+                                                    Stream->selectAudio(Audio);
+                                                }
+                                                WebFileHandle->FileHandle = Stream;
                                             }
                                             break;
                                         case UPNP_RESOURCE_RECORDING:
@@ -303,14 +422,40 @@ UpnpWebFileHandle cUPnPWebServer::open(const char* filename, UpnpOpenFileMode mo
                                                 cRecording* Recording = Recordings.GetByName(RecordFile);
                                                 if(!Recording){
                                                     ERROR("No such recording with file name %s", RecordFile);
-                                                    return NULL;
+                                                    break;
+                                                }
+                                                const char* Npt = Path.get("npt");
+                                                // Fast forward and rewind with the independent frames only
+                                                const char* Speed = Path.get("speed");
+                                                if(Speed){
+                                                    cTrickPlayer* TrickPlayer = cTrickPlayer::newInstance(Recording, Speed);
+                                                    if(!TrickPlayer){
+                                                        ERROR("Unable to start trick play at speed %s", Speed);
+                                                        break;
+                                                    }
+                                                    if(Npt && !TrickPlayer->setStartTime(Npt)){
+                                                        delete TrickPlayer;
+                                                        break;
+                                                    }
+                                                    WebFileHandle->FileHandle = TrickPlayer;
+                                                    break;
                                                 }
                                                 cRecordingPlayer* RecPlayer = cRecordingPlayer::newInstance(Recording);
                                                 if(!RecPlayer){
                                                     ERROR("Unable to start record player. No access?!");
-                                                    return NULL;
+                                                    break;
+                                                }
+                                                const char* Mark = Path.get("mark");
+                                                if((Npt && !RecPlayer->setStartTime(Npt)) || (!Npt && Mark && !RecPlayer->setStartMark(Mark))){
+                                                    delete RecPlayer;
+                                                    break;
                                                 }
                                                 WebFileHandle->FileHandle = RecPlayer;
+                                                if(Recording->LengthInSeconds() > 0){
+                                                    // The bitrate of the video leaves out the audio and the overhead
+                                                    Rate = Recording->FileSizeMB() * 1024.0 * 1024.0 / Recording->LengthInSeconds();
+                                                }
+                                                WebFileHandle->Bucket = cStreamScheduler::getInstance()->attach(Rate);
                                             }
                                             break;
                                         case UPNP_RESOURCE_FILE:
@@ -319,14 +464,21 @@ UpnpWebFileHandle cUPnPWebServer::open(const char* filename, UpnpOpenFileMode mo
                                                 cFilePlayer* RecPlayer = cFilePlayer::newInstance(Resource->getResource());
                                                 if(!RecPlayer){
                                                     ERROR("Unable to start the file player. No access?!");
-                                                    return NULL;
+                                                    break;
                                                 }
                                                 WebFileHandle->FileHandle = RecPlayer;
+                                                WebFileHandle->Bucket = cStreamScheduler::getInstance()->attach(Rate);
 									        }
                                             break;
                                         case UPNP_RESOURCE_URL:
                                         default:
-                                            return NULL;
+                                            break;
+                                    }
+                                    if(!WebFileHandle->FileHandle){
+                                        // The stream could not be opened, its slot is given back
+                                        cAdmissionControl::getInstance()->release(ResourceID, WebFileHandle->ResourceType);
+                                        delete WebFileHandle;
+                                        return NULL;
                                     }
                                 }
                             }
@@ -339,20 +491,26 @@ UpnpWebFileHandle cUPnPWebServer::open(const char* filename, UpnpOpenFileMode mo
                     case UPNP_WEB_METHOD_SEARCH:
                     case UPNP_WEB_METHOD_DOWNLOAD:
                     default:
-                        ERROR("Unknown or unsupported method ID (%d)", Method);
+                        ERROR("Unknown or unsupported method ID (%d)", Path.Method);
                         return NULL;
                 }
                 break;
             default:
-                ERROR("Unknown or unsupported section ID (%d).", Section);
+                ERROR("Unknown or unsupported section ID (%d).", Path.Section);
                 return NULL;
         }
     }
     else {
         return NULL;
     }
+    // Renderers may ask for the stream with time stamps
+    const char* Tts = Path.get("tts");
+    if(Tts && atoi(Tts)){
+        WebFileHandle->FileHandle = new cTimestampedStream(WebFileHandle->FileHandle);
+    }
     MESSAGE(VERBOSE_WEBSERVER, "Open the file handle");
     WebFileHandle->FileHandle->open(mode);
+    WebFileHandle->Stream = cMetrics::getInstance()->openStream(WebFileHandle->ResourceID, WebFileHandle->ResourceType, WebFileHandle->FileHandle);
     return (UpnpWebFileHandle)WebFileHandle;
 }
 
@@ -365,12 +523,22 @@ int cUPnPWebServer::write(UpnpWebFileHandle fh, char* buf, size_t buflen){
 int cUPnPWebServer::read(UpnpWebFileHandle fh, char* buf, size_t buflen){
     cWebFileHandle* FileHandle = (cWebFileHandle*)fh;
     MESSAGE(VERBOSE_BUFFERS, "Reading from %s", *FileHandle->Filename);
-    return FileHandle->FileHandle->read(buf, buflen);
+    if(FileHandle->Bucket){
+        FileHandle->Bucket->take(buflen);
+    }
+    uint64_t Start = cMetrics::now();
+    int Bytes = FileHandle->FileHandle->read(buf, buflen);
+    cMetrics::getInstance()->observeRead(FileHandle->Stream, FileHandle->ResourceType, Bytes, cMetrics::now() - Start);
+    return Bytes;
 }
 
 int cUPnPWebServer::seek(UpnpWebFileHandle fh, off_t offset, int origin){
     cWebFileHandle* FileHandle = (cWebFileHandle*)fh;
     MESSAGE(VERBOSE_BUFFERS, "Seeking on %s", *FileHandle->Filename);
+    if(FileHandle->Bucket){
+        // The client has to fill its buffer again
+        FileHandle->Bucket->burst();
+    }
     return FileHandle->FileHandle->seek(offset, origin);
 }
 
@@ -378,6 +546,13 @@ int cUPnPWebServer::close(UpnpWebFileHandle fh){
     cWebFileHandle *FileHandle = (cWebFileHandle *)fh;
     MESSAGE(VERBOSE_WEBSERVER, "Closing file %s", *FileHandle->Filename);
     FileHandle->FileHandle->close();
+    if(FileHandle->Stream){
+        cMetrics::getInstance()->closeStream(FileHandle->Stream);
+    }
+    cStreamScheduler::getInstance()->detach(FileHandle->Bucket);
+    if(FileHandle->ResourceType >= 0){
+        cAdmissionControl::getInstance()->release(FileHandle->ResourceID, FileHandle->ResourceType);
+    }
     delete FileHandle->FileHandle;
     delete FileHandle;
     return 0;
@@ -490,7 +665,7 @@ void * cUPnPWebServer::newTimerFunction(void *epgItemIn){
 		if (count > 0){
 			cList<cUPnPResource>* resList = epgItem->getResources();
 			if (resList){
-				int resMax = min((int)20, resList->Count());
+				int resMax = ::min((int)20, resList->Count());
 				int ctr = 0;
 				for (cUPnPResource* res = (cUPnPResource*)resList->First(); res && ctr++ < resMax; ){
 					MESSAGE(VERBOSE_METADATA, "Record timer flag was: %i", res->getRecordTimer());
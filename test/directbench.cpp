@@ -0,0 +1,206 @@
+/*
+ * File:   directbench.cpp
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+/*
+ * Benchmark of buffered and direct reads of recordings
+ *
+ * This streams a recording with cSegmentedFile, once buffered with read-ahead
+ * and once with O_DIRECT, and reports the rate of each mode together with the
+ * page cache residency of the recording before and after the stream. The
+ * residency is the share of the pages of the segments in the page cache, as
+ * \c mincore() reports it, and the Cached line of /proc/meminfo.
+ *
+ * The recording is dropped from the page cache before each mode, so both
+ * start cold. Pages which another process keeps dirty or locked may stay.
+ *
+ * Usage: directbench <recording directory> [<KB per read>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <vdr/recording.h>
+#include "segmentedfile.h"
+#include "config.h"
+
+#define BENCH_READ_SIZE     64      // KB
+
+// The configuration, which the benchmark sets itself, instead of the plugin
+cUPnPConfig* cUPnPConfig::mInstance = NULL;
+int cUPnPConfig::verbosity = 0;
+
+cUPnPConfig::cUPnPConfig(){
+    this->mReadAhead = STREAM_READ_AHEAD;
+    this->mDirectIO = false;
+}
+
+cUPnPConfig::~cUPnPConfig(){}
+
+cUPnPConfig* cUPnPConfig::get(){
+    if(cUPnPConfig::mInstance == NULL)
+        cUPnPConfig::mInstance = new cUPnPConfig();
+    return cUPnPConfig::mInstance;
+}
+
+struct cResidency {
+    long mResident;                 ///< the pages of the recording in the page cache
+    long mPages;                    ///< the pages of the recording
+    long mCached;                   ///< the Cached line of /proc/meminfo in KB
+};
+
+static double seconds(){
+    struct timespec Now;
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    return Now.tv_sec + Now.tv_nsec / 1e9;
+}
+
+static long cachedKB(){
+    FILE* File = fopen("/proc/meminfo", "r");
+    if(!File){
+        return -1;
+    }
+    char Line[128];
+    long Cached = -1;
+    while(fgets(Line, sizeof(Line), File)){
+        if(sscanf(Line, "Cached: %ld kB", &Cached) == 1){
+            break;
+        }
+    }
+    fclose(File);
+    return Cached;
+}
+
+/**
+ * Calls the function for each segment of the recording
+ *
+ * @return returns the number of segments
+ */
+static int forSegments(
+    const char* Directory,          ///< the directory of the recording
+    bool IsPes,                     ///< the recording consists of PES files
+    void (*Function)(int, off_t, void*), ///< the function, which gets the open segment and its size
+    void* Data                      ///< the data of the function
+){
+    int Maximum = IsPes ? VDR_MAX_FILES_PER_PESRECORDING : VDR_MAX_FILES_PER_TSRECORDING;
+    int Segments = 0;
+    for(int Number = 1; Number <= Maximum; Number++){
+        char Name[4096];
+        snprintf(Name, sizeof(Name), IsPes ? "%s/%03d.vdr" : "%s/%05d.ts", Directory, Number);
+        int File = open(Name, O_RDONLY);
+        if(File < 0){
+            break;
+        }
+        struct stat Stat;
+        if(fstat(File, &Stat) == 0){
+            Function(File, Stat.st_size, Data);
+            Segments++;
+        }
+        close(File);
+    }
+    return Segments;
+}
+
+static void countResident(int File, off_t Size, void* Data){
+    cResidency* Residency = (cResidency*)Data;
+    long PageSize = sysconf(_SC_PAGESIZE);
+    size_t Pages = (Size + PageSize - 1) / PageSize;
+    if(Pages == 0){
+        return;
+    }
+    void* Map = mmap(NULL, Size, PROT_READ, MAP_SHARED, File, 0);
+    if(Map == MAP_FAILED){
+        return;
+    }
+    unsigned char* Vector = new unsigned char[Pages];
+    if(mincore(Map, Size, Vector) == 0){
+        for(size_t i = 0; i < Pages; i++){
+            if(Vector[i] & 1) Residency->mResident++;
+        }
+        Residency->mPages += Pages;
+    }
+    delete [] Vector;
+    munmap(Map, Size);
+}
+
+static void dropCache(int File, off_t, void*){
+    posix_fadvise(File, 0, 0, POSIX_FADV_DONTNEED);
+}
+
+static cResidency residency(const char* Directory, bool IsPes){
+    cResidency Residency = { 0, 0, 0 };
+    forSegments(Directory, IsPes, countResident, &Residency);
+    Residency.mCached = cachedKB();
+    return Residency;
+}
+
+static void printResidency(const char* Label, const cResidency& Residency){
+    printf("  %-8s resident %ld of %ld pages (%.1f%%), Cached %ld kB\n", Label,
+           Residency.mResident, Residency.mPages,
+           Residency.mPages ? 100.0 * Residency.mResident / Residency.mPages : 0.0,
+           Residency.mCached);
+}
+
+static bool stream(const char* Directory, bool IsPes, bool Direct, size_t ReadSize){
+    cUPnPConfig::get()->mDirectIO = Direct;
+    cUPnPConfig::get()->mReadAhead = Direct ? 0 : STREAM_READ_AHEAD;
+    forSegments(Directory, IsPes, dropCache, NULL);
+    cResidency Before = residency(Directory, IsPes);
+
+    cSegmentedFile* File = cSegmentedFile::newInstance(Directory, IsPes);
+    if(!File){
+        fprintf(stderr, "No segments in %s\n", Directory);
+        return false;
+    }
+    char* Buffer = new char[ReadSize];
+    uint64_t Bytes = 0;
+    int Result = 0;
+    double Start = seconds();
+    while((Result = File->read(Buffer, ReadSize)) > 0){
+        Bytes += Result;
+    }
+    double Elapsed = seconds() - Start;
+    long Stalls = File->getStalls();
+    delete [] Buffer;
+    delete File;
+    if(Result < 0){
+        fprintf(stderr, "Failed to read %s\n", Directory);
+        return false;
+    }
+
+    cResidency After = residency(Directory, IsPes);
+    printf("%s: %llu bytes in %.3f s, %.1f MB/s, %ld stalls\n", Direct ? "O_DIRECT" : "buffered",
+           (unsigned long long)Bytes, Elapsed, Elapsed > 0 ? Bytes / Elapsed / (MB(1)) : 0.0, Stalls);
+    printResidency("before", Before);
+    printResidency("after", After);
+    printf("  Cached grew by %ld kB\n", After.mCached - Before.mCached);
+    return true;
+}
+
+int main(int argc, char* argv[]){
+    if(argc < 2){
+        fprintf(stderr, "Usage: %s <recording directory> [<KB per read>]\n", argv[0]);
+        return 2;
+    }
+    const char* Directory = argv[1];
+    int ReadSize = argc > 2 ? atoi(argv[2]) : BENCH_READ_SIZE;
+    if(ReadSize <= 0){
+        ReadSize = BENCH_READ_SIZE;
+    }
+    // PES recordings start with 001.vdr, TS recordings with 00001.ts
+    char Name[4096];
+    snprintf(Name, sizeof(Name), "%s/001.vdr", Directory);
+    bool IsPes = access(Name, R_OK) == 0;
+
+    if(!stream(Directory, IsPes, false, KB(ReadSize))) return 1;
+    if(!stream(Directory, IsPes, true, KB(ReadSize))) return 1;
+    return 0;
+}
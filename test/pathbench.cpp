@@ -0,0 +1,60 @@
+/*
+ * File:   pathbench.cpp
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+/*
+ * Benchmark of the stream path parsers
+ *
+ * This measures how long cPathParser::parse(), the grammar, and
+ * cPathParser::parseFast() take for typical stream paths.
+ *
+ * Usage: pathbench [<number of iterations>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "search.h"
+
+#define BENCH_ITERATIONS    200000
+
+static const char* Paths[] = {
+    "/shares/get?resId=1234",
+    "/shares/get?resId=1234&npt=0:10:00.5&tts=1",
+    "/shares/get?resId=1234&speed=-8",
+    NULL
+};
+
+static double seconds(){
+    struct timespec Now;
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    return Now.tv_sec + Now.tv_nsec / 1e9;
+}
+
+int main(int argc, char* argv[]){
+    int Iterations = argc > 1 ? atoi(argv[1]) : BENCH_ITERATIONS;
+    if(Iterations <= 0){
+        Iterations = BENCH_ITERATIONS;
+    }
+    printf("%-48s %12s %12s %8s\n", "path", "grammar ns", "fast ns", "speedup");
+    for(int i = 0; Paths[i]; i++){
+        int Section, Method;
+        double Start = seconds();
+        for(int j = 0; j < Iterations; j++){
+            propertyMap Properties;
+            cPathParser::parse(Paths[i], &Section, &Method, &Properties);
+        }
+        double Grammar = (seconds() - Start) * 1e9 / Iterations;
+        Start = seconds();
+        for(int j = 0; j < Iterations; j++){
+            cWebPath WebPath;
+            cPathParser::parseFast(Paths[i], &WebPath);
+        }
+        double Fast = (seconds() - Start) * 1e9 / Iterations;
+        printf("%-48s %12.0f %12.0f %7.1fx\n", Paths[i], Grammar, Fast, Fast > 0 ? Grammar / Fast : 0);
+    }
+    return 0;
+}
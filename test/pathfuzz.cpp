@@ -0,0 +1,132 @@
+/*
+ * File:   pathfuzz.cpp
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+/*
+ * Differential fuzz test of the stream path parsers
+ *
+ * This feeds the same paths to cPathParser::parse(), the grammar, and to
+ * cPathParser::parseFast() and checks that both accept the same paths with
+ * the same section, method and properties. The paths are built from pieces
+ * of valid and invalid paths with a fixed seed, so a failure can be repeated.
+ *
+ * Usage: pathfuzz [<number of paths> [<seed>]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include "search.h"
+
+#define FUZZ_PATHS          200000
+#define FUZZ_SHOWN_FAILURES 10
+
+static const char* Corpus[] = {
+    "/shares/get?resId=1",
+    "/shares/get?resId=1&npt=0:10:00.5",
+    "/shares/get?resId=12&mark=3&tts=1",
+    "/shares/get?resId=12&speed=-4",
+    "/shares/get?resId=1&resId=2",
+    "/shares/get?",
+    "/shares/get",
+    "/shares/browse?resId=1",
+    "/shares/show",
+    "/sharesx/get?resId=1",
+    "/shares/getx?resId=1",
+    "/shares/get?resId",
+    "/shares/get?=1",
+    "/shares/get?resId=1&",
+    "/shares/get?resId=%20-_.~,:",
+    "",
+    "/",
+    NULL
+};
+
+static const char* Pieces[] = {
+    "/shares", "/", "get", "browse", "show", "?", "&", "=", "resId", "npt", "1", "0:01:00.5",
+    "-_.%~,:", "x", "tts", "mark", "speed", "-4", " ", "#", "/sharesx", "getx", ""
+};
+
+#define PIECES  (int)(sizeof(Pieces) / sizeof(*Pieces))
+
+static std::string randomPath(){
+    std::string Path;
+    if(rand() % 2){
+        Path = "/shares/get?";
+    }
+    if(rand() % 2){
+        // Well formed properties
+        int Properties = 1 + rand() % 4;
+        for(int i = 0; i < Properties; i++){
+            if(i) Path += "&";
+            Path += Pieces[8 + rand() % 3];
+            Path += "=";
+            Path += Pieces[10 + rand() % 3];
+        }
+    }
+    for(int i = rand() % 3; i > 0; i--){
+        Path += Pieces[rand() % PIECES];
+    }
+    if(rand() % 3 == 0){
+        Path += (char)(1 + rand() % 255);
+    }
+    return Path;
+}
+
+static bool agree(const char* Path){
+    int Section = 0, Method = 0;
+    propertyMap Properties;
+    cWebPath WebPath;
+    bool Parsed = cPathParser::parse(Path, &Section, &Method, &Properties);
+    bool ParsedFast = cPathParser::parseFast(Path, &WebPath);
+    if(Parsed != ParsedFast){
+        return false;
+    }
+    if(!Parsed){
+        return true;
+    }
+    if(Section != WebPath.Section || Method != WebPath.Method){
+        return false;
+    }
+    // The grammar keeps the last of several equal keys, like cWebPath::get()
+    for(propertyMap::iterator It = Properties.begin(); It != Properties.end(); It++){
+        const char* Value = WebPath.get(It->first);
+        if(!Value || strcmp(Value, It->second)){
+            return false;
+        }
+    }
+    int Keys = 0;
+    for(int i = 0; i < WebPath.Count; i++){
+        bool Repeated = false;
+        for(int j = i + 1; j < WebPath.Count && !Repeated; j++){
+            Repeated = !strcmp(WebPath.Keys[i], WebPath.Keys[j]);
+        }
+        if(!Repeated) Keys++;
+    }
+    return Keys == (int)Properties.size();
+}
+
+int main(int argc, char* argv[]){
+    int Paths = argc > 1 ? atoi(argv[1]) : FUZZ_PATHS;
+    unsigned int Seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+    int Failures = 0;
+
+    for(int i = 0; Corpus[i]; i++){
+        if(!agree(Corpus[i]) && Failures++ < FUZZ_SHOWN_FAILURES){
+            printf("The parsers disagree on '%s'\n", Corpus[i]);
+        }
+    }
+    srand(Seed);
+    for(int i = 0; i < Paths; i++){
+        std::string Path = randomPath();
+        if(!agree(Path.c_str()) && Failures++ < FUZZ_SHOWN_FAILURES){
+            printf("The parsers disagree on '%s'\n", Path.c_str());
+        }
+    }
+    printf("pathfuzz: %d paths with seed %u, %d failures\n", Paths, Seed, Failures);
+    return Failures ? 1 : 0;
+}
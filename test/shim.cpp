@@ -0,0 +1,127 @@
+/*
+ * File:   shim.cpp
+ * Author: J.Huber, IRT GmbH
+ *
+ * Created on October 17, 2026
+ */
+
+/*
+ * The few functions of VDR and the plugin which the standalone tests and
+ * benchmarks need. They are linked without VDR, so these replace the ones of
+ * VDR's tools and the logging of the plugin.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vdr/tools.h>
+#include <vdr/thread.h>
+#include "../common.h"
+
+cString::cString(const char* S, bool TakePointer){
+    this->s = TakePointer ? (char*)S : S ? strdup(S) : NULL;
+}
+
+cString::~cString(){
+    free(this->s);
+}
+
+cString::cString(const cString& String){
+    this->s = String.s ? strdup(String.s) : NULL;
+}
+
+cString& cString::operator=(const char* S){
+    if(this->s != S){
+        free(this->s);
+        this->s = S ? strdup(S) : NULL;
+    }
+    return *this;
+}
+
+cString cString::sprintf(const char* fmt, ...){
+    va_list ap;
+    va_start(ap, fmt);
+    char* Buffer = NULL;
+    if(vasprintf(&Buffer, fmt, ap) < 0){
+        Buffer = NULL;
+    }
+    va_end(ap);
+    return cString(Buffer, true);
+}
+
+cTimeMs::cTimeMs(int Ms){
+    this->Set(Ms);
+}
+
+uint64_t cTimeMs::Now(){
+    struct timespec Now;
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    return (uint64_t)Now.tv_sec * 1000 + Now.tv_nsec / 1000000;
+}
+
+void cTimeMs::Set(int Ms){
+    this->begin = Now() + Ms;
+}
+
+uint64_t cTimeMs::Elapsed(){
+    return Now() - this->begin;
+}
+
+// The tests and benchmarks are single threaded, so the locks do nothing
+cMutex::cMutex(){}
+
+cMutex::~cMutex(){}
+
+cMutexLock::cMutexLock(cMutex*){}
+
+cMutexLock::~cMutexLock(){}
+
+cListObject::cListObject(){
+    this->prev = this->next = NULL;
+}
+
+cListObject::~cListObject(){}
+
+void cListObject::Append(cListObject* Object){
+    this->next = Object;
+    Object->prev = this;
+}
+
+cListBase::cListBase(){
+    this->objects = this->lastObject = NULL;
+    this->count = 0;
+}
+
+cListBase::~cListBase(){
+    this->Clear();
+}
+
+void cListBase::Add(cListObject* Object, cListObject*){
+    // The tests only append
+    if(this->lastObject){
+        this->lastObject->Append(Object);
+    }
+    else {
+        this->objects = Object;
+    }
+    this->lastObject = Object;
+    this->count++;
+}
+
+void cListBase::Move(int, int){}
+
+void cListBase::Clear(){
+    while(this->objects){
+        cListObject* Object = this->objects->Next();
+        delete this->objects;
+        this->objects = Object;
+    }
+    this->lastObject = NULL;
+    this->count = 0;
+}
+
+void message(int, const char*, int, const char*, ...){}
+
+void syslog_with_tid(int, const char*, ...){}
@@ -4,7 +4,7 @@
  * See the README file for copyright information and how to reach the author.
  * Author:
  * Author: J.Huber, IRT GmbH
- * Last modification: April 15, 2013
+ * Last modification: October 17, 2026
  * $Id$
  */
 
@@ -102,7 +102,70 @@ const char *cPluginUpnp::CommandLineHelp(void)
             "                  --dbdir=<directory>   The directory in which the\n"
             "                                        metadata database is stored\n"
             "                  --httpdir=<directory> The directory where the\n"
-            "                                        http documents are located\n"),
+            "                                        http documents are located\n"
+            "                  --slowreader=<policy> What happens to live TV clients\n"
+            "                                        which fall behind the shared\n"
+            "                                        receiver: 'drop' skips the lost\n"
+            "                                        data, 'disconnect' ends the\n"
+            "                                        stream. Default: drop\n"
+            "                  --pooltime=<sec>      Keep live TV receivers attached for\n"
+            "                                        <sec> seconds after the last client\n"
+            "                                        has gone, so switching back to the\n"
+            "                                        channel starts instantly.\n"
+            "                                        Default: 0 (disabled)\n"
+            "                  --pretune=<n>         Tune the <n> channels before and\n"
+            "                                        after a watched channel on spare\n"
+            "                                        devices. Requires --pooltime.\n"
+            "                                        Default: 0 (disabled)\n"
+            "                  --timeshift=<MB>      Keep the last <MB> megabytes of every\n"
+            "                                        live TV channel in a timeshift file,\n"
+            "                                        so clients can pause and seek.\n"
+            "                                        Default: 0 (disabled)\n"
+            "                  --timeshiftdir=<dir>  The directory of the timeshift files.\n"
+            "                                        Default: the plugin config directory\n"
+            "                  --livebufmin=<KB>     The minimum size of a live TV buffer.\n"
+            "                                        Default: 256\n"
+            "                  --livebufmax=<KB>     The maximum size of a live TV buffer.\n"
+            "                                        The buffers are sized to hold two\n"
+            "                                        seconds of the channel within these\n"
+            "                                        limits. Default: 16384\n"
+            "                  --radiots             Stream radio channels as MPEG\n"
+            "                                        transport stream. By default only\n"
+            "                                        the MPEG audio or AAC-ADTS frames of\n"
+            "                                        the first audio track are streamed.\n"
+            "                  --failover=<ms>       Attach a live TV receiver to another\n"
+            "                                        device, if its device delivered no\n"
+            "                                        data for <ms> milliseconds. The\n"
+            "                                        clients stay connected meanwhile.\n"
+            "                                        0 disables the watchdog.\n"
+            "                                        Default: 2000\n"
+            "                  --readahead=<KB>      Let the kernel read <KB> kilobytes\n"
+            "                                        ahead of every recording stream, so\n"
+            "                                        a slow disk does not stall the\n"
+            "                                        client. 0 disables the read-ahead.\n"
+            "                                        Default: 4096\n"
+            "                  --pacing=<percent>    Limit every recording stream to\n"
+            "                                        <percent> of its average rate, after\n"
+            "                                        a burst of 10 seconds at the start\n"
+            "                                        and after seeks. 0 disables pacing.\n"
+            "                                        Default: 200\n"
+            "                  --directio            Read recordings with O_DIRECT, so\n"
+            "                                        streams do not evict other data\n"
+            "                                        from the page cache. Disables the\n"
+            "                                        read-ahead.\n"
+            "                  --tts                 Offer every TV channel and video\n"
+            "                                        recording as timestamped transport\n"
+            "                                        stream with 192 byte packets, too.\n"
+            "                  --maxstreams=<n>      Open at most <n> streams at once.\n"
+            "                                        Recordings leave 2 of them free for\n"
+            "                                        live TV, files leave 4 free for both.\n"
+            "                                        Further requests are rejected.\n"
+            "                                        Default: 16\n"
+            "                  --maxperresource=<n>  Open at most <n> streams of the same\n"
+            "                                        recording or file at once. The\n"
+            "                                        clients of a channel share its\n"
+            "                                        receiver and are not limited.\n"
+            "                                        Default: 4\n"),
             0,
             SERVER_MIN_PORT,
             SERVER_MAX_PORT
@@ -3,7 +3,7 @@
  * Author: savop
  * Author: J.Huber, IRT GmbH
  * Created on 21. August 2009, 16:12
- * Last Modification: November 6, 2012
+ * Last Modification: October 17, 2026
  */
 
 #include <upnp/ixml.h>
@@ -12,6 +12,7 @@
 #include "upnp/contentdirectory.h"
 #include "../common.h"
 #include "util.h"
+#include "metrics.h"
 
 cContentDirectory::cContentDirectory(UpnpDevice_Handle DeviceHandle, cMediaDatabase* MediaDatabase)
 : cUpnpService(DeviceHandle) {
@@ -72,16 +73,29 @@ int cContentDirectory::execute(Upnp_Action_Request* Request){
         return UPNP_E_BAD_REQUEST;
     }
 //	MESSAGE(VERBOSE_CDS, "Content directory service, execute %s", Request->ActionName);
-    if(!strcmp(Request->ActionName, UPNP_CDS_ACTION_BROWSE))
-        return this->browse(Request);
-    if(!strcmp(Request->ActionName, UPNP_CDS_ACTION_SEARCHCAPABILITIES))
-        return this->getSearchCapabilities(Request);
-    if(!strcmp(Request->ActionName, UPNP_CDS_ACTION_SORTCAPABILITIES))
-        return this->getSortCapabilities(Request);
-    if(!strcmp(Request->ActionName, UPNP_CDS_ACTION_SYSTEMUPDATEID))
-        return this->getSystemUpdateID(Request);
-
-    return UPNP_E_BAD_REQUEST;
+    uint64_t Start = cMetrics::now();
+    // Unknown actions are counted together, clients choose their names
+    const char* Action = "unknown";
+    int Result = UPNP_E_BAD_REQUEST;
+    if(!strcmp(Request->ActionName, UPNP_CDS_ACTION_BROWSE)){
+        Action = UPNP_CDS_ACTION_BROWSE;
+        Result = this->browse(Request);
+    }
+    else if(!strcmp(Request->ActionName, UPNP_CDS_ACTION_SEARCHCAPABILITIES)){
+        Action = UPNP_CDS_ACTION_SEARCHCAPABILITIES;
+        Result = this->getSearchCapabilities(Request);
+    }
+    else if(!strcmp(Request->ActionName, UPNP_CDS_ACTION_SORTCAPABILITIES)){
+        Action = UPNP_CDS_ACTION_SORTCAPABILITIES;
+        Result = this->getSortCapabilities(Request);
+    }
+    else if(!strcmp(Request->ActionName, UPNP_CDS_ACTION_SYSTEMUPDATEID)){
+        Action = UPNP_CDS_ACTION_SYSTEMUPDATEID;
+        Result = this->getSystemUpdateID(Request);
+    }
+
+    cMetrics::getInstance()->observeAction(Action, Result != UPNP_E_SUCCESS, cMetrics::now() - Start);
+    return Result;
 }
 
 